@@ -1,91 +1,364 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <time.h>
 #include "fast.h"
 
+/*
+ * Parameterized microbenchmark harness.
+ *
+ * The default run (no arguments) sweeps tree sizes with uniform keys
+ * and uniform queries, as the original benchmark did.  Every axis that
+ * distinguishes production traffic from that idealized load can be set
+ * independently:
+ *
+ *   --keys N             number of keys                  (default 1000000)
+ *   --queries M          number of probes                (default 5000000)
+ *   --key-dist D         uniform | dense | clustered     (default uniform)
+ *   --query-dist D       uniform | zipf | sequential | antiprefetch
+ *   --zipf-theta X       Zipf skew in [0,1)              (default 0.99)
+ *   --hit-ratio X        fraction of probes hitting a key (default 0.5)
+ *   --cold               evict the tree before the timed pass (default: a
+ *                        full untimed warm pass precedes the timed one)
+ *   --batch              probe through fast_search_batch
+ *   --seed S             RNG seed                        (default 42)
+ *   --csv FILE           append one CSV row (header written if new)
+ *
+ * Key distributions: `uniform` spaces keys by random gaps, `dense`
+ * packs them two apart, `clustered` builds tight runs separated by
+ * ~1M-wide gaps (hot tables with per-tenant ranges).  Query
+ * distributions: `zipf` uses the standard Gray et al. generator over
+ * key ranks, `sequential` scans ascending, `antiprefetch` alternates
+ * between distant halves of the key space so no prefetcher — hardware
+ * or FAST_PREFETCH=1 — sees a usable pattern.  Misses probe the gap
+ * just above a key, so they traverse the full tree like hits do.
+ *
+ * The CSV is consumed by bench/report.py --bench-csv.
+ */
+
+struct bench_cfg {
+    size_t n;
+    size_t m;
+    const char *key_dist;
+    const char *query_dist;
+    double zipf_theta;
+    double hit_ratio;
+    int cold;
+    int batch;
+    unsigned long long seed;
+    const char *csv_path;
+};
+
+/* ------------------------------------------------------------------ */
+/* Deterministic RNG (xorshift64*), so runs are comparable across      */
+/* machines and reruns regardless of libc.                             */
+/* ------------------------------------------------------------------ */
+
+static unsigned long long rng_state;
+
+static unsigned long long rng_next(void)
+{
+    unsigned long long x = rng_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    rng_state = x;
+    return x * 2685821657736338717ULL;
+}
+
+static double rng_unit(void)
+{
+    return (double)(rng_next() >> 11) / 9007199254740992.0;  /* [0,1) */
+}
+
 static double time_diff_sec(struct timespec *start, struct timespec *end)
 {
     return (double)(end->tv_sec - start->tv_sec) +
            (double)(end->tv_nsec - start->tv_nsec) / 1e9;
 }
 
-static void bench_size(size_t n, size_t num_queries)
+/* ------------------------------------------------------------------ */
+/* Key generation.  All distributions keep gaps >= 2 so key + 1 is     */
+/* always a genuine miss.                                              */
+/* ------------------------------------------------------------------ */
+
+static void gen_keys(int32_t *keys, size_t n, const char *dist)
+{
+    int64_t v = 1;
+
+    if (strcmp(dist, "dense") == 0) {
+        for (size_t i = 0; i < n; i++)
+            keys[i] = (int32_t)(i * 2 + 1);
+    } else if (strcmp(dist, "clustered") == 0) {
+        /* ~1M-wide gaps between runs, shrunk when n runs would not
+           fit in the int32 range. */
+        int64_t gap = (0x7fff0000LL - 2 * (int64_t)n) /
+                      (int64_t)(n / 512 + 1);
+        if (gap > (1 << 20)) gap = 1 << 20;
+        if (gap < 2) gap = 2;
+        for (size_t i = 0; i < n; i++) {
+            if (i > 0 && i % 512 == 0)
+                v += gap;
+            keys[i] = (int32_t)v;
+            v += 2;
+        }
+    } else {                              /* uniform */
+        /* Random gaps sized so n keys span most of the int32 range
+           without overflowing it. */
+        unsigned long long span = 0x7fff0000ULL / (n ? n : 1);
+        if (span < 2) span = 2;
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = (int32_t)v;
+            v += 2 + (int64_t)(rng_next() % span);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Query generation: pick a key rank per the query distribution, then  */
+/* probe the key itself or the gap above it per the hit ratio.         */
+/* ------------------------------------------------------------------ */
+
+/* Zipf over ranks 0..n-1 (Gray et al., SIGMOD '94). */
+struct zipf_gen {
+    size_t n;
+    double theta, alpha, zetan, eta;
+};
+
+static void zipf_init(struct zipf_gen *z, size_t n, double theta)
+{
+    z->n = n;
+    z->theta = theta;
+    z->zetan = 0.0;
+    for (size_t i = 1; i <= n; i++)
+        z->zetan += 1.0 / pow((double)i, theta);
+    z->alpha = 1.0 / (1.0 - theta);
+    z->eta = (1.0 - pow(2.0 / (double)n, 1.0 - theta)) /
+             (1.0 - (1.0 + pow(0.5, theta)) / z->zetan);
+}
+
+static size_t zipf_next(const struct zipf_gen *z)
 {
-    int32_t *keys = (int32_t *)malloc(n * sizeof(int32_t));
-    int32_t *queries = (int32_t *)malloc(num_queries * sizeof(int32_t));
-    if (!keys || !queries) {
-        fprintf(stderr, "allocation failed for n=%zu\n", n);
+    double u = rng_unit();
+    double uz = u * z->zetan;
+
+    if (uz < 1.0)
+        return 0;
+    if (uz < 1.0 + pow(0.5, z->theta))
+        return 1;
+    size_t r = (size_t)((double)z->n *
+                        pow(z->eta * u - z->eta + 1.0, z->alpha));
+    return (r < z->n) ? r : z->n - 1;
+}
+
+static void gen_queries(int32_t *queries, size_t m, const int32_t *keys,
+                        size_t n, const struct bench_cfg *cfg)
+{
+    struct zipf_gen zg = {0};
+    int zipf = strcmp(cfg->query_dist, "zipf") == 0;
+    int seq = strcmp(cfg->query_dist, "sequential") == 0;
+    int anti = strcmp(cfg->query_dist, "antiprefetch") == 0;
+    size_t half = (n > 1) ? n / 2 : 1;
+
+    if (zipf)
+        zipf_init(&zg, n, cfg->zipf_theta);
+
+    for (size_t i = 0; i < m; i++) {
+        size_t j;
+        if (zipf) {
+            j = zipf_next(&zg);
+        } else if (seq) {
+            j = i % n;
+        } else if (anti) {
+            /* Alternate between distant halves with coprime strides:
+               consecutive probes never share a page block. */
+            j = (i & 1) ? n - 1 - ((i / 2) * 7919) % half
+                        : ((i / 2) * 104729) % half;
+        } else {                          /* uniform */
+            j = (size_t)(rng_next() % n);
+        }
+        queries[i] = (rng_unit() < cfg->hit_ratio) ? keys[j] : keys[j] + 1;
+    }
+}
+
+/* Push the tree (and everything else) out of the cache hierarchy. */
+static void evict_caches(void)
+{
+    static char *sweep;
+    const size_t bytes = 256u << 20;
+    volatile long long sink = 0;
+
+    if (!sweep)
+        sweep = (char *)malloc(bytes);
+    if (!sweep)
+        return;
+    memset(sweep, 1, bytes);
+    for (size_t i = 0; i < bytes; i += 64)
+        sink += sweep[i];
+    (void)sink;
+}
+
+/* ------------------------------------------------------------------ */
+
+static int run_config(const struct bench_cfg *cfg)
+{
+    int32_t *keys = (int32_t *)malloc(cfg->n * sizeof(int32_t));
+    int32_t *queries = (int32_t *)malloc(cfg->m * sizeof(int32_t));
+    int64_t *results = cfg->batch
+        ? (int64_t *)malloc(cfg->m * sizeof(int64_t)) : NULL;
+    if (!keys || !queries || (cfg->batch && !results)) {
+        fprintf(stderr, "allocation failed for n=%zu\n", cfg->n);
         free(keys);
         free(queries);
-        return;
+        free(results);
+        return 1;
     }
 
-    /* Generate sorted unique keys */
-    for (size_t i = 0; i < n; i++)
-        keys[i] = (int32_t)(i * 3 + 1);
+    rng_state = cfg->seed | 1;
+    gen_keys(keys, cfg->n, cfg->key_dist);
+    gen_queries(queries, cfg->m, keys, cfg->n, cfg);
 
-    /* Generate random queries within key range */
-    int32_t max_key = keys[n - 1];
-    for (size_t i = 0; i < num_queries; i++)
-        queries[i] = (int32_t)(rand() % (max_key + 1));
-
-    /* Build tree */
     struct timespec t0, t1;
     clock_gettime(CLOCK_MONOTONIC, &t0);
-    fast_tree_t *tree = fast_create(keys, n);
+    fast_tree_t *tree = fast_create(keys, cfg->n);
     clock_gettime(CLOCK_MONOTONIC, &t1);
-
     if (!tree) {
-        fprintf(stderr, "fast_create failed for n=%zu\n", n);
+        fprintf(stderr, "fast_create failed for n=%zu\n", cfg->n);
         free(keys);
         free(queries);
-        return;
+        free(results);
+        return 1;
     }
-
     double build_sec = time_diff_sec(&t0, &t1);
 
-    /* Warm up */
     volatile int64_t sink = 0;
-    for (size_t i = 0; i < 1000 && i < num_queries; i++)
-        sink += fast_search(tree, queries[i]);
+    if (cfg->cold) {
+        evict_caches();
+    } else {
+        for (size_t i = 0; i < cfg->m; i++)
+            sink += fast_search(tree, queries[i]);
+    }
 
-    /* Benchmark search */
     clock_gettime(CLOCK_MONOTONIC, &t0);
-    for (size_t i = 0; i < num_queries; i++)
-        sink += fast_search(tree, queries[i]);
+    if (cfg->batch) {
+        fast_search_batch(tree, queries, cfg->m, results);
+        sink += results[cfg->m - 1];
+    } else {
+        for (size_t i = 0; i < cfg->m; i++)
+            sink += fast_search(tree, queries[i]);
+    }
     clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sink;
 
     double search_sec = time_diff_sec(&t0, &t1);
-    double queries_per_sec = (double)num_queries / search_sec;
-    double ns_per_query = search_sec * 1e9 / (double)num_queries;
+    double mqps = (double)cfg->m / search_sec / 1e6;
+    double nsq = search_sec * 1e9 / (double)cfg->m;
 
-    printf("  N=%-12zu  build: %8.3f ms  search: %8.1f Mqueries/s  (%5.1f ns/query)\n",
-           n, build_sec * 1000.0, queries_per_sec / 1e6, ns_per_query);
+    printf("  N=%-10zu %-9s  Q=%-9zu %-13s hit=%.2f %-5s %-6s  "
+           "build: %8.3f ms  %8.2f Mq/s  %6.2f ns/query\n",
+           cfg->n, cfg->key_dist, cfg->m, cfg->query_dist, cfg->hit_ratio,
+           cfg->cold ? "cold" : "warm", cfg->batch ? "batch" : "single",
+           build_sec * 1000.0, mqps, nsq);
+
+    if (cfg->csv_path) {
+        FILE *f = fopen(cfg->csv_path, "a");
+        if (!f) {
+            perror(cfg->csv_path);
+        } else {
+            if (ftell(f) == 0)
+                fprintf(f, "keys,key_dist,queries,query_dist,zipf_theta,"
+                           "hit_ratio,phase,mode,build_ms,mqps,"
+                           "ns_per_query\n");
+            fprintf(f, "%zu,%s,%zu,%s,%.3f,%.3f,%s,%s,%.3f,%.3f,%.3f\n",
+                    cfg->n, cfg->key_dist, cfg->m, cfg->query_dist,
+                    cfg->zipf_theta, cfg->hit_ratio,
+                    cfg->cold ? "cold" : "warm",
+                    cfg->batch ? "batch" : "single",
+                    build_sec * 1000.0, mqps, nsq);
+            fclose(f);
+        }
+    }
 
-    (void)sink;
     fast_destroy(tree);
     free(keys);
     free(queries);
+    free(results);
+    return 0;
 }
 
-int main(void)
+static void usage(const char *argv0)
 {
-    printf("FAST Tree Benchmark\n");
-    printf("====================\n\n");
+    fprintf(stderr,
+        "Usage: %s [--keys N] [--queries M] [--key-dist D] [--query-dist D]\n"
+        "       [--zipf-theta X] [--hit-ratio X] [--cold] [--batch]\n"
+        "       [--seed S] [--csv FILE]\n"
+        "Key distributions:   uniform dense clustered\n"
+        "Query distributions: uniform zipf sequential antiprefetch\n"
+        "Without arguments, runs the default size sweep.\n", argv0);
+}
 
-    srand((unsigned)time(NULL));
+int main(int argc, char **argv)
+{
+    struct bench_cfg cfg = {
+        .n = 1000000,
+        .m = 5000000,
+        .key_dist = "uniform",
+        .query_dist = "uniform",
+        .zipf_theta = 0.99,
+        .hit_ratio = 0.5,
+        .cold = 0,
+        .batch = 0,
+        .seed = 42,
+        .csv_path = NULL,
+    };
 
-    size_t sizes[] = {1000, 10000, 100000, 1000000, 10000000};
-    size_t num_sizes = sizeof(sizes) / sizeof(sizes[0]);
-    size_t num_queries = 10000000;
+    if (argc == 1) {
+        printf("FAST Tree Benchmark\n");
+        printf("====================\n\n");
+        size_t sizes[] = {1000, 10000, 100000, 1000000, 10000000};
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            cfg.n = sizes[i];
+            cfg.m = (sizes[i] > 1000000) ? 5000000 : 10000000;
+            if (run_config(&cfg) != 0)
+                return 1;
+        }
+        printf("\n");
+        return 0;
+    }
 
-    for (size_t i = 0; i < num_sizes; i++) {
-        if (sizes[i] > 1000000)
-            num_queries = 5000000;
-        bench_size(sizes[i], num_queries);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            cfg.n = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) {
+            cfg.m = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--key-dist") == 0 && i + 1 < argc) {
+            cfg.key_dist = argv[++i];
+        } else if (strcmp(argv[i], "--query-dist") == 0 && i + 1 < argc) {
+            cfg.query_dist = argv[++i];
+        } else if (strcmp(argv[i], "--zipf-theta") == 0 && i + 1 < argc) {
+            cfg.zipf_theta = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--hit-ratio") == 0 && i + 1 < argc) {
+            cfg.hit_ratio = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--cold") == 0) {
+            cfg.cold = 1;
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            cfg.batch = 1;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            cfg.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            cfg.csv_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
     }
 
-    printf("\n");
-    return 0;
+    if (cfg.n == 0 || cfg.m == 0 ||
+        cfg.zipf_theta < 0.0 || cfg.zipf_theta >= 1.0 ||
+        cfg.hit_ratio < 0.0 || cfg.hit_ratio > 1.0) {
+        usage(argv[0]);
+        return 1;
+    }
+    return run_config(&cfg);
 }
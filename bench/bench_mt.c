@@ -0,0 +1,224 @@
+/*
+ * Multi-core read scaling benchmark: N reader threads hammer one shared
+ * fast_tree_t, the production shape for this library.  For each thread
+ * count we report aggregate and per-thread throughput plus sampled tail
+ * latency (p50/p99/p999), and after the sweep the scaling knee — the
+ * point where marginal efficiency collapses, which in practice is where
+ * the shared LLC and memory bandwidth saturate.
+ *
+ * Usage: fast_bench_mt [tree_size] [ms_per_point]
+ *   tree_size     keys in the shared tree (default 16M, ~64MB layout,
+ *                 well past LLC so searches exercise memory)
+ *   ms_per_point  measurement window per thread count (default 500)
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "fast.h"
+
+#define QUERY_POOL    (1u << 22)  /* shared random query pool */
+#define SAMPLE_EVERY  64          /* measure every 64th query */
+#define MAX_SAMPLES   65536       /* per thread */
+
+static double time_diff_sec(struct timespec *start, struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) +
+           (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+struct worker {
+    const fast_tree_t *tree;
+    const int32_t *queries;
+    pthread_barrier_t *start;
+    const volatile int *stop;
+    int tid;
+
+    size_t iters;
+    double sec;
+    uint64_t *samples;        /* sampled per-query latencies, ns */
+    size_t nsamples;
+};
+
+static void *worker_main(void *arg)
+{
+    struct worker *w = (struct worker *)arg;
+    const fast_tree_t *tree = w->tree;
+    const int32_t *queries = w->queries;
+    size_t pos = (size_t)w->tid * 7919;  /* decorrelate thread streams */
+    volatile int64_t sink = 0;
+    struct timespec t0, t1;
+
+    /* Pin to a core so the sweep measures cores, not the scheduler */
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(w->tid % (int)sysconf(_SC_NPROCESSORS_ONLN), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+    pthread_barrier_wait(w->start);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    while (!*w->stop) {
+        /* One sampled query, then a batch of unsampled ones */
+        struct timespec s0, s1;
+        clock_gettime(CLOCK_MONOTONIC, &s0);
+        sink += fast_search(tree, queries[pos++ & (QUERY_POOL - 1)]);
+        clock_gettime(CLOCK_MONOTONIC, &s1);
+        if (w->nsamples < MAX_SAMPLES)
+            w->samples[w->nsamples++] =
+                (uint64_t)(s1.tv_sec - s0.tv_sec) * 1000000000ull +
+                (uint64_t)(s1.tv_nsec - s0.tv_nsec);
+
+        for (int i = 1; i < SAMPLE_EVERY; i++)
+            sink += fast_search(tree, queries[pos++ & (QUERY_POOL - 1)]);
+        w->iters += SAMPLE_EVERY;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    w->sec = time_diff_sec(&t0, &t1);
+    (void)sink;
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t percentile(const uint64_t *sorted, size_t n, double p)
+{
+    if (n == 0)
+        return 0;
+    size_t idx = (size_t)(p * (double)(n - 1));
+    return sorted[idx];
+}
+
+/* Run one thread count; returns aggregate Mqueries/s. */
+static double run_point(const fast_tree_t *tree, const int32_t *queries,
+                        int nthreads, int ms)
+{
+    pthread_barrier_t start;
+    volatile int stop = 0;
+    pthread_barrier_init(&start, NULL, (unsigned)nthreads + 1);
+
+    struct worker *workers =
+        (struct worker *)calloc((size_t)nthreads, sizeof(struct worker));
+    pthread_t *tids = (pthread_t *)malloc((size_t)nthreads * sizeof(pthread_t));
+    uint64_t *merged =
+        (uint64_t *)malloc((size_t)nthreads * MAX_SAMPLES * sizeof(uint64_t));
+    if (!workers || !tids || !merged) {
+        fprintf(stderr, "allocation failed\n");
+        exit(1);
+    }
+
+    for (int i = 0; i < nthreads; i++) {
+        workers[i] = (struct worker){
+            .tree = tree, .queries = queries,
+            .start = &start, .stop = &stop, .tid = i,
+            .samples = (uint64_t *)malloc(MAX_SAMPLES * sizeof(uint64_t)),
+        };
+        pthread_create(&tids[i], NULL, worker_main, &workers[i]);
+    }
+
+    pthread_barrier_wait(&start);
+    usleep((useconds_t)ms * 1000);
+    stop = 1;
+
+    size_t total_iters = 0, nmerged = 0;
+    double min_thr = 1e30, max_thr = 0, total_thr = 0;
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(tids[i], NULL);
+        total_iters += workers[i].iters;
+        double thr = (double)workers[i].iters / workers[i].sec / 1e6;
+        if (thr < min_thr) min_thr = thr;
+        if (thr > max_thr) max_thr = thr;
+        total_thr += thr;
+        memcpy(merged + nmerged, workers[i].samples,
+               workers[i].nsamples * sizeof(uint64_t));
+        nmerged += workers[i].nsamples;
+        free(workers[i].samples);
+    }
+    qsort(merged, nmerged, sizeof(uint64_t), cmp_u64);
+
+    printf("  %7d  %10.1f  %8.2f  %8.2f  %6lu  %6lu  %6lu\n",
+           nthreads, total_thr, min_thr, max_thr,
+           (unsigned long)percentile(merged, nmerged, 0.50),
+           (unsigned long)percentile(merged, nmerged, 0.99),
+           (unsigned long)percentile(merged, nmerged, 0.999));
+    fflush(stdout);
+
+    free(merged);
+    free(tids);
+    free(workers);
+    pthread_barrier_destroy(&start);
+    (void)total_iters;
+    return total_thr;
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = (argc > 1) ? (size_t)atoll(argv[1]) : (size_t)16 * 1024 * 1024;
+    int ms = (argc > 2) ? atoi(argv[2]) : 500;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu < 1) ncpu = 1;
+
+    printf("FAST Multi-Core Read Scaling\n");
+    printf("============================\n\n");
+    printf("tree: %zu keys (%.1f MB layout), %ld cpus, %d ms/point\n\n",
+           n, (double)n * 4 / 1048576.0, ncpu, ms);
+
+    int32_t *keys = (int32_t *)malloc(n * sizeof(int32_t));
+    int32_t *queries = (int32_t *)malloc(QUERY_POOL * sizeof(int32_t));
+    if (!keys || !queries) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+    for (size_t i = 0; i < n; i++)
+        keys[i] = (int32_t)(i * 3 + 1);
+    srand(42);
+    for (size_t i = 0; i < QUERY_POOL; i++)
+        queries[i] = (int32_t)((uint32_t)rand() % (uint32_t)keys[n - 1]);
+
+    fast_tree_t *tree = fast_create(keys, n);
+    if (!tree) {
+        fprintf(stderr, "fast_create failed\n");
+        return 1;
+    }
+
+    printf("  threads  total Mq/s  min Mq/s  max Mq/s  p50 ns  p99 ns  p999 ns\n");
+
+    /* 1, 2, 4, ... plus ncpu itself */
+    double thr[64];
+    int counts[64], npoints = 0;
+    for (int t = 1; t < (int)ncpu && npoints < 63; t *= 2)
+        counts[npoints++] = t;
+    counts[npoints++] = (int)ncpu;
+
+    for (int i = 0; i < npoints; i++)
+        thr[i] = run_point(tree, queries, counts[i], ms);
+
+    /* The saturation point: once doubling threads stops buying at least
+       ~30% more aggregate throughput, the shared LLC and memory
+       bandwidth are the limiter rather than core count. */
+    int knee = counts[npoints - 1];
+    for (int i = 1; i < npoints; i++) {
+        if (thr[i] < thr[i - 1] * 1.3) {
+            knee = counts[i - 1];
+            break;
+        }
+    }
+    printf("\nscaling knee: ~%d threads "
+           "(beyond this, LLC/memory bandwidth is the limiter; "
+           "size query fanout accordingly)\n\n", knee);
+
+    fast_destroy(tree);
+    free(keys);
+    free(queries);
+    return 0;
+}
@@ -471,9 +471,80 @@ def generate_pdf(results, sys_info, use_perf, output_path):
         plt.close(fig)
 
 
+# ── Workload report (fast_bench --csv output) ──────────────────────
+
+def load_bench_csv(path):
+    """Load rows written by fast_bench --csv into a list of dicts."""
+    import csv
+
+    rows = []
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            for key in ("keys", "queries"):
+                row[key] = int(row[key])
+            for key in ("zipf_theta", "hit_ratio", "build_ms",
+                        "mqps", "ns_per_query"):
+                row[key] = float(row[key])
+            rows.append(row)
+    return rows
+
+
+def generate_workload_pdf(rows, sys_info, output_path):
+    """One page per (keys, phase, mode) group: ns/query bars grouped by
+    query distribution, one bar cluster per key distribution."""
+    groups = defaultdict(list)
+    for row in rows:
+        groups[(row["keys"], row["phase"], row["mode"])].append(row)
+
+    with PdfPages(output_path) as pdf:
+        for (keys, phase, mode), grp in sorted(groups.items()):
+            qdists = sorted({r["query_dist"] for r in grp})
+            kdists = sorted({r["key_dist"] for r in grp})
+
+            fig, ax = plt.subplots(figsize=(11, 8.5))
+            width = 0.8 / max(len(kdists), 1)
+            x = np.arange(len(qdists))
+            for ki, kd in enumerate(kdists):
+                vals = []
+                for qd in qdists:
+                    match = [r["ns_per_query"] for r in grp
+                             if r["key_dist"] == kd and
+                             r["query_dist"] == qd]
+                    vals.append(np.mean(match) if match else 0.0)
+                ax.bar(x + ki * width, vals, width, label=f"keys: {kd}")
+
+            ax.set_xticks(x + width * (len(kdists) - 1) / 2)
+            ax.set_xticklabels(qdists)
+            ax.set_ylabel("ns / query")
+            ax.set_title(f"FAST workload sweep — N={fmt_size(keys)}, "
+                         f"{phase} cache, {mode} probes\n"
+                         f"{sys_info.get('cpu', '?')}")
+            ax.legend()
+            ax.grid(axis="y", alpha=0.3)
+            pdf.savefig(fig)
+            plt.close(fig)
+
+
 # ── Main ───────────────────────────────────────────────────────────
 
 def main():
+    # CSV mode: plot rows already collected by fast_bench --csv runs
+    # instead of driving fast_bench_perf under perf.
+    if len(sys.argv) > 1 and sys.argv[1] == "--bench-csv":
+        if len(sys.argv) < 3:
+            print("Usage: report.py --bench-csv results.csv [output.pdf]")
+            sys.exit(1)
+        csv_path = sys.argv[2]
+        output_path = sys.argv[3] if len(sys.argv) > 3 else "fast_workload.pdf"
+        rows = load_bench_csv(csv_path)
+        if not rows:
+            print(f"No rows in {csv_path}")
+            sys.exit(1)
+        print(f"Loaded {len(rows)} runs from {csv_path}")
+        generate_workload_pdf(rows, get_system_info(), output_path)
+        print(f"Done. Report saved to {output_path}")
+        return
+
     build_dir = sys.argv[1] if len(sys.argv) > 1 else "build"
     output_path = sys.argv[2] if len(sys.argv) > 2 else "fast_report.pdf"
 
@@ -59,14 +59,48 @@ _lib.fast_size.restype = ctypes.c_size_t
 _lib.fast_key_at.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
 _lib.fast_key_at.restype = ctypes.c_int32
 
+_lib.fast_search_batch.argtypes = [ctypes.c_void_p,
+                                   ctypes.POINTER(ctypes.c_int32),
+                                   ctypes.c_size_t,
+                                   ctypes.POINTER(ctypes.c_int64)]
+_lib.fast_search_batch.restype = None
+
+_lib.fast_search_lower_bound_batch.argtypes = [ctypes.c_void_p,
+                                               ctypes.POINTER(ctypes.c_int32),
+                                               ctypes.c_size_t,
+                                               ctypes.POINTER(ctypes.c_int64)]
+_lib.fast_search_lower_bound_batch.restype = None
+
+
+def _int32_buffer(values):
+    """Marshal keys into one C int32 array, returning (array, length).
+
+    Objects exposing a contiguous int32 buffer (NumPy int32 arrays,
+    array('i', ...), memoryviews) are copied with a single memcpy;
+    anything else falls back to element-by-element conversion.
+    """
+    try:
+        mv = memoryview(values)
+        if mv.format == "i" and mv.contiguous:
+            n = mv.nbytes // 4
+            return (ctypes.c_int32 * n).from_buffer_copy(mv), n
+    except TypeError:
+        pass
+    n = len(values)
+    return (ctypes.c_int32 * n)(*values), n
+
 
 class FastTree:
     """A FAST (Fast Architecture Sensitive Tree) for high-throughput search."""
 
     def __init__(self, keys):
-        """Build a FAST tree from a sorted list of 32-bit integer keys."""
-        arr = (ctypes.c_int32 * len(keys))(*keys)
-        self._ptr = _lib.fast_create(arr, len(keys))
+        """Build a FAST tree from sorted 32-bit integer keys.
+
+        Accepts any sequence, or a contiguous int32 buffer (e.g. a
+        NumPy array) which is passed to C without per-element work.
+        """
+        arr, n = _int32_buffer(keys)
+        self._ptr = _lib.fast_create(arr, n)
         if not self._ptr:
             raise MemoryError("fast_create failed")
 
@@ -97,3 +131,22 @@ class FastTree:
     def key_at(self, index):
         """Return the key at the given sorted index."""
         return _lib.fast_key_at(self._ptr, index)
+
+    def search_batch(self, queries):
+        """Vectorized search: one FFI crossing for the whole array.
+
+        queries may be any sequence or contiguous int32 buffer; returns
+        a ctypes int64 array (index with [] or wrap in e.g.
+        numpy.frombuffer without copying).
+        """
+        arr, n = _int32_buffer(queries)
+        out = (ctypes.c_int64 * n)()
+        _lib.fast_search_batch(self._ptr, arr, n, out)
+        return out
+
+    def lower_bound_batch(self, queries):
+        """Vectorized lower_bound; same conventions as search_batch."""
+        arr, n = _int32_buffer(queries)
+        out = (ctypes.c_int64 * n)()
+        _lib.fast_search_lower_bound_batch(self._ptr, arr, n, out)
+        return out
@@ -31,6 +31,9 @@ module Fast
     attach_function :fast_search_lower_bound, [:pointer, :int32],        :int64
     attach_function :fast_size,               [:pointer],                :size_t
     attach_function :fast_key_at,             [:pointer, :size_t],       :int32
+    attach_function :fast_search_batch,       [:pointer, :pointer, :size_t, :pointer], :void
+    attach_function :fast_search_lower_bound_batch,
+                    [:pointer, :pointer, :size_t, :pointer], :void
   end
 
   class Tree
@@ -49,6 +52,16 @@ module Fast
       Lib.fast_search_lower_bound(@ptr, key)
     end
 
+    # Vectorized variants: the whole query array crosses the FFI
+    # boundary once, instead of one attach_function call per key.
+    def search_batch(keys)
+      batch(keys) { |q, n, r| Lib.fast_search_batch(@ptr, q, n, r) }
+    end
+
+    def lower_bound_batch(keys)
+      batch(keys) { |q, n, r| Lib.fast_search_lower_bound_batch(@ptr, q, n, r) }
+    end
+
     def size
       Lib.fast_size(@ptr)
     end
@@ -63,5 +76,15 @@ module Fast
         @ptr = nil
       end
     end
+
+    private
+
+    def batch(keys)
+      q = FFI::MemoryPointer.new(:int32, keys.length)
+      q.write_array_of_int32(keys)
+      r = FFI::MemoryPointer.new(:int64, keys.length)
+      yield q, keys.length, r
+      r.read_array_of_int64(keys.length)
+    end
   end
 end
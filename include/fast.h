@@ -17,9 +17,186 @@ typedef struct fast_tree fast_tree_t;
  */
 fast_tree_t *fast_create(const int32_t *keys, size_t n);
 
+/*
+ * Like fast_create, but backs the tree layout with 2MB hugepages
+ * (explicit MAP_HUGETLB if the system has hugepages reserved, else
+ * transparent hugepages via madvise) and adds a 2MB superpage blocking
+ * level to the layout, so large trees burn one dTLB entry per 2MB of
+ * tree instead of one per 4KB.  Falls back to a normal allocation when
+ * no hugepage backing is available.
+ */
+fast_tree_t *fast_create_huge(const int32_t *keys, size_t n);
+
+/*
+ * Like fast_create, but lays out the page-block subtrees across
+ * `nthreads` threads.  Each subtree writes a disjoint range of the
+ * layout, so the build scales nearly linearly for large trees.
+ * nthreads <= 0 uses the number of online CPUs.
+ */
+fast_tree_t *fast_create_parallel(const int32_t *keys, size_t n, int nthreads);
+
+/*
+ * Like fast_create, but the keys may arrive in any order: a parallel
+ * radix sort runs as part of the build, sorting straight into the
+ * tree's own key array so the builder skips its usual copy pass — a
+ * full ingest makes one less pass over the data than sorting first and
+ * calling fast_create.  Already-sorted input is detected with a single
+ * scan and skips the sort entirely.  Uses all online CPUs for both the
+ * sort and the layout, like fast_create_parallel.
+ */
+fast_tree_t *fast_create_unsorted(const int32_t *keys, size_t n);
+
+/*
+ * Like fast_create, but omits the sorted_rank side array, roughly
+ * halving per-tree memory: the sorted index is recomputed from the
+ * traversal path instead (each descent's child-index bits uniquely
+ * determine the in-order rank).  Search results are identical.
+ */
+fast_tree_t *fast_create_compact(const int32_t *keys, size_t n);
+
+/*
+ * Like fast_create_compact, but stores page blocks as a per-block base
+ * key plus unsigned 16-bit deltas, halving the layout footprint and
+ * doubling the keys compared per cache line and per SSE register.
+ * Blocks whose key range exceeds 16 bits fall back to raw int32
+ * storage, so any distribution is supported; dense ones compress.
+ * Compressed trees cannot be saved with fast_save.
+ */
+fast_tree_t *fast_create_compressed(const int32_t *keys, size_t n);
+
+/*
+ * Bump-pointer arena for building many trees without per-tree heap
+ * traffic.  One slab of the given size is allocated up front; every
+ * tree built in it with fast_create_in lives entirely inside the slab
+ * (struct, keys, layout, rank table and all build scratch), so after
+ * the arena itself no allocator calls are made.  Budget roughly 3x the
+ * key bytes per tree (2x for compact trees) plus a little slack.
+ */
+typedef struct fast_arena fast_arena_t;
+
+/* Allocate an arena of `bytes` capacity.  NULL on failure. */
+fast_arena_t *fast_arena_create(size_t bytes);
+
+/*
+ * Discard every tree built in the arena and make its full capacity
+ * available again.  All fast_tree_t pointers from the arena's
+ * fast_create_in calls become invalid.
+ */
+void fast_arena_reset(fast_arena_t *arena);
+
+/* Free the arena and everything built in it. */
+void fast_arena_destroy(fast_arena_t *arena);
+
+/*
+ * Like fast_create, but allocation-free: the tree is carved out of the
+ * arena.  Returns NULL if the arena's remaining capacity is too small.
+ * Arena trees are reclaimed by fast_arena_reset/destroy — fast_destroy
+ * on them is a no-op — and are build-once (no fast_insert/fast_merge).
+ */
+fast_tree_t *fast_create_in(fast_arena_t *arena, const int32_t *keys, size_t n);
+
+/*
+ * Like fast_create, but with a fixed-size payload per key: values[i]
+ * belongs to keys[i] and is copied into a cache-aligned value array
+ * owned by the tree, so fast_search_value answers a lookup from one
+ * structure — one traversal plus one final value line — instead of the
+ * tree and a caller-side value table missing separately.  kv trees are
+ * build-once (no fast_insert) and cannot be saved with fast_save.
+ */
+fast_tree_t *fast_create_kv(const int32_t *keys, const void *values,
+                            size_t n, size_t value_size);
+
+/*
+ * Point search with payload: like fast_search, but also copies the
+ * matched key's value into value_out (left untouched when the query
+ * precedes all keys).  Returns the index, or -1 on a miss or if the
+ * tree was not built with fast_create_kv.
+ */
+int64_t fast_search_value(const fast_tree_t *tree, int32_t key,
+                          void *value_out);
+
+/*
+ * Zero-copy access to the tree's value array (sorted-key order, one
+ * value_size slot per key), or NULL for key-only trees.  Same lifetime
+ * rules as fast_keys_ptr.
+ */
+const void *fast_values_ptr(const fast_tree_t *tree);
+
+/*
+ * Like fast_create, but tuned for skewed query distributions: `sample`
+ * is a representative draw of expected queries (a few thousand keys is
+ * plenty).  The top tree levels and the hottest page-block subtrees —
+ * enough to cover ~90% of the sample — are mlocked, prefaulted and
+ * hugepage-hinted so the hot working set stays resident, and the cold
+ * blocks are hinted for reclaim first, keeping p99 latency off the
+ * cold-fetch path.  Search results are identical to fast_create; all
+ * hints are best effort (an unprivileged process may exceed
+ * RLIMIT_MEMLOCK, in which case the tree simply runs unpinned).
+ * A NULL/empty sample degrades to a plain fast_create.  Pinned trees
+ * are build-once (no fast_insert/fast_merge): rebuild and re-learn
+ * when the key set changes.
+ */
+fast_tree_t *fast_create_tiered(const int32_t *keys, size_t n,
+                                const int32_t *sample, size_t sample_n);
+
+/*
+ * NUMA placement policies for fast_create_numa.
+ */
+typedef enum {
+    FAST_NUMA_INTERLEAVE = 0,  /* spread layout pages across all nodes */
+    FAST_NUMA_REPLICATE  = 1,  /* one replica per node, probes routed
+                                  to the caller's local copy */
+} fast_numa_policy_t;
+
+/*
+ * Like fast_create, but places the tree for multi-socket machines:
+ * interleaving averages remote-access cost across sockets, replication
+ * removes cross-socket traffic from the probe path entirely at
+ * nodes x memory cost.  On single-node systems (or kernels without
+ * NUMA support) this degrades to a plain fast_create.
+ */
+fast_tree_t *fast_create_numa(const int32_t *keys, size_t n,
+                              fast_numa_policy_t policy);
+
 /* Free all memory associated with the tree. */
 void fast_destroy(fast_tree_t *tree);
 
+/*
+ * Insert a key without rebuilding: it lands in a small sorted delta
+ * buffer that every search consults alongside the main layout, so the
+ * tree behaves as if the key had been in the build input (indices,
+ * size, ranges all reflect the merged sequence).  Reads pay one extra
+ * binary search over the buffer, so call fast_merge once the buffer
+ * has grown past a few thousand keys.  Returns 0 on success, -1 on
+ * allocation failure or for mmap-opened, NUMA-replicated and tiered
+ * trees, which stay build-once.
+ */
+int fast_insert(fast_tree_t *tree, int32_t key);
+
+/*
+ * Fold the delta buffer into a freshly blocked layout, restoring full
+ * probe speed.  The rebuild runs with the tree's original settings
+ * (parallel build threads, compact/compressed mode, hugepages) and the
+ * live tree is untouched if it fails.  A no-op when the buffer is
+ * empty.  Returns 0 on success, -1 on failure.
+ */
+int fast_merge(fast_tree_t *tree);
+
+/*
+ * Write a versioned on-disk image of the tree (header plus the layout,
+ * rank and key arrays).  Returns 0 on success, -1 on I/O error or if
+ * unmerged inserts are pending (call fast_merge first).
+ */
+int fast_save(const fast_tree_t *tree, const char *path);
+
+/*
+ * Reopen a saved tree by mmap-ing the file: no rebuild, O(1) startup,
+ * pages faulted in on demand and shared between processes via the page
+ * cache.  Returns NULL if the file is missing, truncated, or has an
+ * unknown format version.  Destroy with fast_destroy as usual.
+ */
+fast_tree_t *fast_open_mmap(const char *path);
+
 /*
  * Point search: return the index (into the original sorted key array)
  * of the largest key <= query.  Returns -1 if query < all keys.
@@ -32,12 +209,336 @@ int64_t fast_search(const fast_tree_t *tree, int32_t key);
  */
 int64_t fast_search_lower_bound(const fast_tree_t *tree, int32_t key);
 
+/*
+ * Batched point search: results[i] = fast_search(tree, queries[i]) for
+ * i in [0, m).  Interleaves several concurrent traversals to overlap
+ * their cache misses, so independent lookups (join probes, bulk
+ * filters) run substantially faster than m calls to fast_search.
+ */
+void fast_search_batch(const fast_tree_t *tree, const int32_t *queries,
+                       size_t m, int64_t *results);
+
+/*
+ * Batched lower-bound search: results[i] = fast_search_lower_bound(
+ * tree, queries[i]) for i in [0, m), with the same miss-overlapping
+ * pipeline as fast_search_batch.  Both batch entry points take
+ * caller-owned arrays, so language bindings can hand over a whole
+ * query buffer (a NumPy array, an FFI memory region) in one call
+ * instead of paying the binding-crossing cost per key.
+ */
+void fast_search_lower_bound_batch(const fast_tree_t *tree,
+                                   const int32_t *queries, size_t m,
+                                   int64_t *results);
+
+/*
+ * Suspended traversal state for a single interleaved search.  The
+ * struct is public only so callers can embed one per in-flight request
+ * (no allocation on the hot path); apart from `result` and `done`,
+ * every field is private descent state and must not be touched.
+ */
+typedef struct fast_cursor {
+    const fast_tree_t *tree;  /* NULL once the search is complete */
+    int32_t key;
+    int64_t result;           /* valid once done != 0 */
+    size_t  base_s, base_p, base_l, base_k;
+    size_t  c_s, c_p, c_l;
+    size_t  path;
+    int     rem_s, rem_p, rem_l, rem_k;
+    int     t_s, t_p, t_l;
+    int     child_index;
+    int     leaf_depth;
+    int     lb;
+    int     done;             /* nonzero when result is valid */
+} fast_cursor_t;
+
+/*
+ * Coroutine-style interleaved search for latency-bound request
+ * streams.  The batch entry points need the queries to arrive
+ * together; an RPC service gets them one at a time on many
+ * connections.  fast_search_begin runs the descent one SIMD block and
+ * suspends with the prefetch for the next block already issued;
+ * fast_search_step resumes after the caller has done other work.  An
+ * event loop multiplexing dozens of cursors overlaps all their cache
+ * misses, recovering batch-level memory parallelism at per-request
+ * arrival times.
+ *
+ * fast_search_step returns 1 when the cursor is done (cursor->result
+ * holds what fast_search would have returned) and 0 when it suspended
+ * again.  Modes without a resumable int32 descent — compressed trees,
+ * scalar-forced trees, non-SIMD builds — complete inside
+ * fast_search_begin, so callers need no special cases: just step until
+ * done.  fast_lower_bound_begin is the fast_search_lower_bound
+ * counterpart, mirroring the batch API pairing.
+ */
+void fast_search_begin(const fast_tree_t *tree, int32_t key,
+                       fast_cursor_t *cursor);
+void fast_lower_bound_begin(const fast_tree_t *tree, int32_t key,
+                            fast_cursor_t *cursor);
+int fast_search_step(fast_cursor_t *cursor);
+
+/*
+ * Bulk probe offload to the GPU engine (built with -DFAST_ENABLE_CUDA).
+ * The blocked layout is uploaded once per tree and cached on the
+ * device; each call then streams the queries through in chunks, one
+ * thread per query.  Worthwhile from a few million probes per call —
+ * keep fast_search / fast_search_batch as the latency tier.
+ * Returns 0 on success (results[] filled exactly as fast_search_batch
+ * would), -1 when the engine is compiled out, no device is present, or
+ * the tree is compressed or has unmerged inserts; on -1 the caller
+ * should fall back to fast_search_batch.
+ */
+int fast_search_batch_gpu(const fast_tree_t *tree, const int32_t *queries,
+                          size_t m, int64_t *results);
+
+/* Return 1 if the library was built with the GPU engine and a CUDA
+   device is present, else 0. */
+int fast_gpu_available(void);
+
 /* Return the number of keys in the tree. */
 size_t fast_size(const fast_tree_t *tree);
 
 /* Return the key at the given index in the original sorted order. */
 int32_t fast_key_at(const fast_tree_t *tree, size_t index);
 
+/* Return the number of keys in the inclusive range [lo, hi]. */
+size_t fast_range_count(const fast_tree_t *tree, int32_t lo, int32_t hi);
+
+/*
+ * Copy the keys in the inclusive range [lo, hi], in ascending order,
+ * into out (at most max entries).  Returns the number of keys copied.
+ * A range scan is two tree descents plus one memcpy-speed sweep.
+ */
+size_t fast_range_copy(const fast_tree_t *tree, int32_t lo, int32_t hi,
+                       int32_t *out, size_t max);
+
+/*
+ * Write the keys present in both trees (each distinct common key once,
+ * ascending) into out, at most max entries.  Returns the number
+ * written.  A galloping merge over the two sorted key arrays: the
+ * lagging side advances four keys per SSE compare and jumps over large
+ * gaps with a single lower-bound descent, so cost scales with the
+ * smaller input.  Keys inserted since the last fast_merge on either
+ * tree are not visited.
+ */
+size_t fast_intersect(const fast_tree_t *a, const fast_tree_t *b,
+                      int32_t *out, size_t max);
+
+/*
+ * Callback for fast_merge_join: one call per distinct common key, with
+ * the index of the key's first occurrence in each tree.
+ */
+typedef void (*fast_join_fn)(int32_t key, int64_t index_a, int64_t index_b,
+                             void *arg);
+
+/*
+ * Merge join over two trees: invokes fn for every distinct key present
+ * in both, in ascending order, and returns the number of matches.
+ * Same galloping merge (and same unmerged-insert caveat) as
+ * fast_intersect, without materializing the result.
+ */
+size_t fast_merge_join(const fast_tree_t *a, const fast_tree_t *b,
+                       fast_join_fn fn, void *arg);
+
+/*
+ * Zero-copy access to the tree's sorted key array.  Keys inserted since
+ * the last fast_merge are not visible through this pointer.
+ * The pointer is owned by the tree and valid until fast_destroy; use it
+ * with fast_search_lower_bound to stream over a range without any
+ * per-element call overhead.
+ */
+const int32_t *fast_keys_ptr(const fast_tree_t *tree);
+
+/*
+ * Hot-path counters, aggregated over every thread that has probed the
+ * tree since it was created.  Available when the library is configured
+ * with -DFAST_STATS=ON; the default build compiles the counters out
+ * entirely, so the search paths carry zero instrumentation cost.
+ *
+ * The ratios are the diagnostics: levels / searches above log2(n)
+ * means the layout has degraded relative to the key count (rebuild or
+ * merge pending inserts), leaf_scans / searches drifting toward its
+ * cap of 3 means heavy duplicate-boundary traffic, bounds_exits /
+ * searches measures how often queries fall outside the key range, and
+ * batch_steps / batch_rounds is the average pipeline occupancy (out of
+ * the 8 cursor slots) — low values mean batches too small to hide the
+ * memory latency.
+ */
+struct fast_stats {
+    uint64_t searches;      /* descents started */
+    uint64_t levels;        /* tree levels those descents traversed */
+    uint64_t leaf_scans;    /* forward fixup steps in leaf resolution */
+    uint64_t bounds_exits;  /* queries answered by the boundary checks */
+    uint64_t batch_rounds;  /* batch pipeline passes over the cursor slots */
+    uint64_t batch_steps;   /* cursor steps taken by those passes */
+};
+
+/*
+ * Sum the tree's counters into *out.  Returns 0 on success, -1 (with
+ * *out zeroed) when the counters are compiled out or the tree is not
+ * instrumented (arena-resident trees never are).  Counting uses one
+ * per-thread cache line and relaxed atomic adds, so leaving it enabled
+ * in production costs a few percent at worst.
+ */
+int fast_stats_get(const fast_tree_t *tree, struct fast_stats *out);
+
+/*
+ * Epoch-based tree handle for zero-downtime reindexing.  A handle
+ * holds the live tree; readers snapshot it with two uncontended
+ * atomic ops and no lock, and a publish destroys the displaced tree
+ * only after every reader of it has released — no reader-writer lock,
+ * no reader ever blocked by a reindex.
+ */
+typedef struct fast_handle fast_handle_t;
+
+/*
+ * Create a handle, optionally seeded with an initial tree (NULL is
+ * fine; publish one later).  The handle owns every tree given to it
+ * and destroys them as they are displaced.
+ */
+fast_handle_t *fast_handle_create(fast_tree_t *tree);
+
+/*
+ * Install `tree` as the live tree.  Blocks the caller (never the
+ * readers) until all readers of the displaced tree drain, then
+ * destroys it.  Publishers serialize against each other.  Returns 0,
+ * or -1 for a NULL handle.
+ */
+int fast_handle_publish(fast_handle_t *handle, fast_tree_t *tree);
+
+/*
+ * Pin and return the current tree, or NULL when nothing has been
+ * published.  Search it freely — it cannot be destroyed under the
+ * caller — and release it promptly: one straggling reader holds up
+ * the next publish (but never other readers).
+ */
+const fast_tree_t *fast_handle_acquire(fast_handle_t *handle);
+
+/* Unpin a tree returned by fast_handle_acquire (NULL is a no-op). */
+void fast_handle_release(fast_handle_t *handle, const fast_tree_t *tree);
+
+/*
+ * Destroy the handle and any trees it still owns.  The caller must
+ * ensure no reader holds an acquired tree and no publish is in
+ * flight.
+ */
+void fast_handle_destroy(fast_handle_t *handle);
+
+/*
+ * Sharded forest: many trees behind one search entry point, for
+ * keyspaces split into shards to stay under per-tree rebuild-time
+ * budgets.  Queries are routed through a FAST tree built over the
+ * shard boundaries — the same branch-free SIMD descent as the shards,
+ * replacing the branchy boundary binary search applications otherwise
+ * run before every probe.  Results are global ranks over the
+ * concatenated keyspace, so the forest answers exactly like one big
+ * tree built over all the shards' keys.
+ */
+typedef struct fast_forest fast_forest_t;
+
+/*
+ * Assemble a forest from `count` trees.  boundaries[i] is the lowest
+ * key shard i may hold and must be strictly increasing; shard i owns
+ * [boundaries[i], boundaries[i+1]).  The forest takes ownership of the
+ * trees (they are destroyed with it) and snapshots their sizes, so
+ * shards must not be mutated afterwards.  Returns NULL on invalid
+ * arguments or allocation failure; the trees are untouched on failure.
+ */
+fast_forest_t *fast_forest_create(fast_tree_t *const *trees,
+                                  const int32_t *boundaries, size_t count);
+
+/* Predecessor / lower-bound search over the whole forest; same
+   semantics as fast_search / fast_search_lower_bound with global
+   indices. */
+int64_t fast_forest_search(const fast_forest_t *forest, int32_t key);
+int64_t fast_forest_lower_bound(const fast_forest_t *forest, int32_t key);
+
+/*
+ * Batched forest search: routes all m queries through the boundary
+ * tree's pipelined batch search, groups them per shard, and runs one
+ * batch per shard — each shard's upper levels are pulled into cache
+ * once per batch instead of once per query.  results[i] =
+ * fast_forest_search(forest, queries[i]).
+ */
+void fast_forest_search_batch(const fast_forest_t *forest,
+                              const int32_t *queries, size_t m,
+                              int64_t *results);
+
+/* Total number of keys across all shards. */
+size_t fast_forest_size(const fast_forest_t *forest);
+
+/* Destroy the forest, the boundary tree, and every shard tree. */
+void fast_forest_destroy(fast_forest_t *forest);
+
+/*
+ * 64-bit key variant, sharing the type-parameterized layout and search
+ * implementation.  8-byte keys halve the fan-out per block (3 keys per
+ * AVX2 block, 7 per cache line), and the trees are always built in
+ * compact mode.  Semantics mirror the 32-bit functions.
+ */
+typedef struct fast64_tree fast64_tree_t;
+
+/* Build a FAST tree from a sorted array of 64-bit keys. */
+fast64_tree_t *fast64_create(const int64_t *keys, size_t n);
+
+/* Free all memory associated with the tree. */
+void fast64_destroy(fast64_tree_t *tree);
+
+/* Return the index of the largest key <= query, or -1 if none. */
+int64_t fast64_search(const fast64_tree_t *tree, int64_t key);
+
+/* Return the index of the first key >= query, or fast64_size if none. */
+int64_t fast64_search_lower_bound(const fast64_tree_t *tree, int64_t key);
+
+/* Return the number of keys in the tree. */
+size_t fast64_size(const fast64_tree_t *tree);
+
+/* Return the key at the given index in the original sorted order. */
+int64_t fast64_key_at(const fast64_tree_t *tree, size_t index);
+
+/*
+ * Byte-string keys.  Each key's first 8 bytes, taken big-endian, form
+ * an order-preserving integer prefix indexed by the 64-bit blocked
+ * layout, so string probes run the same SIMD descent as integer keys;
+ * bytes beyond the prefix live in a compact tail pool that breaks ties
+ * within a run of equal prefixes (keys sharing a long common prefix —
+ * URLs, UUID blocks — are resolved by a binary search over their
+ * tails).  Keys compare as memcmp over their bytes, shorter-is-smaller
+ * on a shared prefix.
+ */
+typedef struct fast_str_tree fast_str_tree_t;
+
+/*
+ * Build a string tree from n keys sorted in ascending memcmp order;
+ * keys[i] points at lens[i] bytes (embedded NULs are fine — lengths,
+ * not terminators, delimit the keys, which are copied in).  Returns
+ * NULL on allocation failure or n == 0.
+ */
+fast_str_tree_t *fast_str_create(const void *const *keys, const size_t *lens,
+                                 size_t n);
+
+/* Free all memory associated with the tree. */
+void fast_str_destroy(fast_str_tree_t *tree);
+
+/* Return the index of the largest key <= the query bytes, or -1. */
+int64_t fast_str_search(const fast_str_tree_t *tree, const void *key,
+                        size_t len);
+
+/* Return the index of the first key >= the query bytes, or
+   fast_str_size if none. */
+int64_t fast_str_lower_bound(const fast_str_tree_t *tree, const void *key,
+                             size_t len);
+
+/* Return the number of keys in the tree. */
+size_t fast_str_size(const fast_str_tree_t *tree);
+
+/*
+ * Copy the key at the given index into out (at most max bytes) and
+ * return its full length, or 0 for an out-of-range index.  Call with
+ * max == 0 to size a buffer.
+ */
+size_t fast_str_key_at(const fast_str_tree_t *tree, size_t index,
+                       void *out, size_t max);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,6 +1,204 @@
 #include "fast_internal.h"
 
+#include <sys/mman.h>
+
+/*
+ * Choose the SIMD blocking depth for a new tree.  Probed once via CPUID
+ * so a single libfast.so serves SSE2-, AVX2- and AVX-512-class machines.
+ * The FAST_SIMD environment variable ("sse", "avx2", "avx512") can force
+ * a narrower width than the hardware supports, which is useful for
+ * benchmarking the kernels against each other; it can never force an
+ * unsupported one.
+ */
+void fast_pick_simd_width(struct fast_tree *t)
+{
+    int d_k = FAST_DK;
+
+#if FAST_HAVE_AVX_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        d_k = FAST_DK_AVX512;
+    else if (__builtin_cpu_supports("avx2"))
+        d_k = FAST_DK_AVX2;
+
+    const char *force = getenv("FAST_SIMD");
+    if (force) {
+        if (strcmp(force, "sse") == 0)
+            d_k = FAST_DK;
+        else if (strcmp(force, "avx2") == 0 && d_k >= FAST_DK_AVX2)
+            d_k = FAST_DK_AVX2;
+        else if (strcmp(force, "avx512") == 0 && d_k >= FAST_DK_AVX512)
+            d_k = FAST_DK_AVX512;
+    }
+#endif
+
+#if FAST_HAVE_SVE
+    /* SVE's vector length is a runtime property: size the block depth
+       so 2^d_K - 1 keys fill the vector, up to the cache line depth.
+       FAST_SIMD=neon narrows to the 128-bit NEON kernel. */
+    {
+        unsigned lanes = (unsigned)svcntw();
+        while (d_k < FAST_DK_MAX && (2u << d_k) <= lanes + 1)
+            d_k++;
+        const char *force = getenv("FAST_SIMD");
+        if (force && strcmp(force, "neon") == 0)
+            d_k = FAST_DK;
+    }
+#endif
+
+    t->d_k = d_k;
+    t->n_k = (1 << d_k) - 1;
+    /* With d_K = 4 one SIMD block fills a cache line; with d_K = 3 a
+       d_L of 3 keeps blocks from straddling cache line block borders. */
+    t->d_l = (d_k == FAST_DK_AVX2) ? FAST_DK_AVX2 : FAST_DL;
+}
+
+/*
+ * SIMD blocking depth for 64-bit keys: 8-byte lanes halve the per-block
+ * fan-out at every width, and an SSE block degenerates to a single key
+ * (served by the scalar node walk).  Same CPUID probe and FAST_SIMD
+ * narrowing override as the 32-bit path.
+ */
+void fast64_pick_simd_width(struct fast64_tree *t)
+{
+    int d_k = FAST64_DK;
+
+#if FAST_HAVE_AVX_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        d_k = FAST64_DK_AVX512;
+    else if (__builtin_cpu_supports("avx2"))
+        d_k = FAST64_DK_AVX2;
+
+    const char *force = getenv("FAST_SIMD");
+    if (force) {
+        if (strcmp(force, "sse") == 0)
+            d_k = FAST64_DK;
+        else if (strcmp(force, "avx2") == 0 && d_k >= FAST64_DK_AVX2)
+            d_k = FAST64_DK_AVX2;
+        else if (strcmp(force, "avx512") == 0 && d_k >= FAST64_DK_AVX512)
+            d_k = FAST64_DK_AVX512;
+    }
+#endif
+
+    t->d_k = d_k;
+    t->n_k = (1 << d_k) - 1;
+    /* 7 keys * 8 bytes = 56 bytes: one cache line block at every width. */
+    t->d_l = FAST64_DL;
+}
+
+/*
+ * Hot-path counter support (FAST_STATS builds).  Threads are spread
+ * over the tree's counter slots by a process-wide round-robin id, so
+ * up to FAST_STATS_SLOTS concurrent readers increment disjoint cache
+ * lines; beyond that, slots are shared but the relaxed atomics keep
+ * the sums exact.
+ */
+#ifdef FAST_STATS
+
+unsigned fast_stats_slot_id(void)
+{
+    static _Atomic unsigned next_slot;
+    static _Thread_local unsigned slot;   /* 0 = not yet assigned */
+
+    if (slot == 0)
+        slot = 1u + atomic_fetch_add_explicit(&next_slot, 1u,
+                                              memory_order_relaxed)
+                        % FAST_STATS_SLOTS;
+    return slot - 1;
+}
+
+void fast_stats_attach(struct fast_tree *t)
+{
+    void *slots = NULL;
+    size_t bytes = FAST_STATS_SLOTS * sizeof(struct fast_stats_slot);
+
+    if (posix_memalign(&slots, 64, bytes) != 0)
+        return;                   /* tree just stays uninstrumented */
+    memset(slots, 0, bytes);
+    t->stats = slots;
+}
+
+#else
+
+void fast_stats_attach(struct fast_tree *t)
+{
+    (void)t;
+}
+
+#endif /* FAST_STATS */
+
+int fast_stats_get(const fast_tree_t *tree, struct fast_stats *out)
+{
+    if (!tree || !out)
+        return -1;
+    memset(out, 0, sizeof(*out));
+#ifdef FAST_STATS
+    if (!tree->stats)
+        return -1;
+
+    const struct fast_stats_slot *slots =
+        (const struct fast_stats_slot *)tree->stats;
+    uint64_t sum[FAST_ST_COUNT] = {0};
+
+    for (int s = 0; s < FAST_STATS_SLOTS; s++)
+        for (int i = 0; i < FAST_ST_COUNT; i++)
+            sum[i] += atomic_load_explicit(&slots[s].c[i],
+                                           memory_order_relaxed);
+
+    out->searches     = sum[FAST_ST_SEARCHES];
+    out->levels       = sum[FAST_ST_LEVELS];
+    out->leaf_scans   = sum[FAST_ST_LEAF_SCANS];
+    out->bounds_exits = sum[FAST_ST_BOUNDS_EXITS];
+    out->batch_rounds = sum[FAST_ST_BATCH_ROUNDS];
+    out->batch_steps  = sum[FAST_ST_BATCH_STEPS];
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+static fast_tree_t *create_tree(const int32_t *keys, size_t n,
+                                int want_huge, int nthreads, int compact)
+{
+    if (!keys || n == 0)
+        return NULL;
+
+    struct fast_tree *t = (struct fast_tree *)calloc(1, sizeof(struct fast_tree));
+    if (!t)
+        return NULL;
+
+    t->want_huge = want_huge;
+    t->build_threads = nthreads;
+    t->compact = compact;
+    t->prefetch = fast_env_prefetch();
+    fast_pick_simd_width(t);
+
+    if (fast_build_layout(t, keys, n) != 0) {
+        free(t);
+        return NULL;
+    }
+
+    fast_stats_attach(t);
+    return t;
+}
+
 fast_tree_t *fast_create(const int32_t *keys, size_t n)
+{
+    return create_tree(keys, n, 0, 1, 0);
+}
+
+fast_tree_t *fast_create_huge(const int32_t *keys, size_t n)
+{
+    return create_tree(keys, n, 1, 1, 0);
+}
+
+fast_tree_t *fast_create_compact(const int32_t *keys, size_t n)
+{
+    return create_tree(keys, n, 0, 1, 1);
+}
+
+fast_tree_t *fast_create_compressed(const int32_t *keys, size_t n)
 {
     if (!keys || n == 0)
         return NULL;
@@ -9,22 +207,185 @@ fast_tree_t *fast_create(const int32_t *keys, size_t n)
     if (!t)
         return NULL;
 
+    t->build_threads = 1;
+    t->compact = 1;      /* ranks from the descent path; no rank array */
+    t->compressed = 1;
+    /* Block for 2-byte deltas: the transcoder reuses the int32 build's
+       node ordering, so the depths are preset before the build. */
+    t->d_k = FAST_DK16;
+    t->n_k = (1 << FAST_DK16) - 1;
+    t->d_l = FAST_DL16;
+    t->d_p = FAST_DP16;
+
     if (fast_build_layout(t, keys, n) != 0) {
         free(t);
         return NULL;
     }
+    if (fast_compress_layout(t) != 0) {
+        fast_destroy(t);
+        return NULL;
+    }
+    fast_stats_attach(t);
+    return t;
+}
+
+fast_tree_t *fast_create_kv(const int32_t *keys, const void *values,
+                            size_t n, size_t value_size)
+{
+    if (!values || value_size == 0)
+        return NULL;
+
+    fast_tree_t *t = fast_create(keys, n);
+    if (!t)
+        return NULL;
+
+    /* Cache-aligned copy in sorted-key order: values[i] rides along
+       with keys[i], so the index from the descent addresses both. */
+    if (posix_memalign(&t->values, 64, n * value_size) != 0) {
+        t->values = NULL;
+        fast_destroy(t);
+        return NULL;
+    }
+    memcpy(t->values, values, n * value_size);
+    t->value_size = value_size;
+    return t;
+}
+
+int64_t fast_search_value(const fast_tree_t *tree, int32_t key,
+                          void *value_out)
+{
+    if (!tree || !tree->values)
+        return -1;
+
+    int64_t idx = fast_search(tree, key);
+    if (idx >= 0 && value_out)
+        memcpy(value_out,
+               (const char *)tree->values + (size_t)idx * tree->value_size,
+               tree->value_size);
+    return idx;
+}
+
+const void *fast_values_ptr(const fast_tree_t *tree)
+{
+    return tree ? tree->values : NULL;
+}
+
+fast_tree_t *fast_create_in(fast_arena_t *arena, const int32_t *keys, size_t n)
+{
+    if (!arena || !keys || n == 0)
+        return NULL;
+
+    /* Arena exhaustion mid-build just rewinds nothing: the partially
+       bumped space is reclaimed with the rest at reset/destroy. */
+    struct fast_tree *t =
+        (struct fast_tree *)fast_arena_lo_alloc(arena, sizeof(struct fast_tree));
+    if (!t)
+        return NULL;
+    memset(t, 0, sizeof(*t));
+
+    t->arena = arena;
+    t->build_threads = 1;
+    t->prefetch = fast_env_prefetch();
+    fast_pick_simd_width(t);
+
+    if (fast_build_layout(t, keys, n) != 0)
+        return NULL;
 
     return t;
 }
 
+fast_tree_t *fast_create_parallel(const int32_t *keys, size_t n, int nthreads)
+{
+    if (nthreads <= 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (ncpu > 0) ? (int)ncpu : 1;
+    }
+    return create_tree(keys, n, 0, nthreads, 0);
+}
+
+fast_tree_t *fast_create_unsorted(const int32_t *keys, size_t n)
+{
+    if (!keys || n == 0)
+        return NULL;
+
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int nthreads = (ncpu > 0) ? (int)ncpu : 1;
+
+    struct fast_tree *t = (struct fast_tree *)calloc(1, sizeof(struct fast_tree));
+    if (!t)
+        return NULL;
+
+    t->build_threads = nthreads;
+    t->prefetch = fast_env_prefetch();
+    fast_pick_simd_width(t);
+
+    /* Sort straight into the tree's own key array: the builder sees
+       t->keys pre-installed and skips its copy pass, so a full ingest
+       is one pass shorter than sorting first and calling fast_create. */
+    t->keys = (int32_t *)malloc(n * sizeof(int32_t));
+    if (!t->keys || fast_sort_into(t->keys, keys, n, nthreads) != 0) {
+        free(t->keys);
+        free(t);
+        return NULL;
+    }
+
+    if (fast_build_layout(t, t->keys, n) != 0) {
+        free(t);        /* the builder released t->keys on failure */
+        return NULL;
+    }
+
+    fast_stats_attach(t);
+    return t;
+}
+
 void fast_destroy(fast_tree_t *tree)
 {
     if (!tree)
         return;
 
-    free(tree->layout);
+    if (tree->numa_replicated) {
+        for (int i = 0; i < tree->numa_nodes; i++) {
+            if (tree->numa_replicas[i] && tree->numa_replicas[i] != tree)
+                fast_destroy(tree->numa_replicas[i]);
+        }
+    }
+
+    fast_gpu_release(tree);
+
+    if (tree->arena) {
+        /* Arena-resident: everything is reclaimed by the arena. */
+        return;
+    }
+
+    if (tree->from_file) {
+        /* All three arrays live inside the single file mapping */
+        munmap(tree->layout_map, tree->layout_map_bytes);
+        free(tree->stats);
+        free(tree);
+        return;
+    }
+
+    if (tree->hot_pinned) {
+        /* free() does not unlock mlocked pages; release the hot tier
+           so the locked-memory budget is returned (fast_tiered.c). */
+        munlock(tree->layout, tree->layout_size * sizeof(int32_t));
+        munlock(tree->keys, tree->n * sizeof(int32_t));
+        if (tree->sorted_rank)
+            munlock(tree->sorted_rank, tree->layout_size * sizeof(int32_t));
+    }
+
+    if (tree->layout_map)
+        munmap(tree->layout_map, tree->layout_map_bytes);
+    else
+        free(tree->layout);
+    free(tree->comp_deltas);
+    free(tree->comp_dir);
+    free(tree->comp_raw);
+    free(tree->values);
+    free(tree->stats);
     free(tree->sorted_rank);
     free(tree->keys);
+    free(tree->delta);
     free(tree);
 }
 
@@ -33,23 +394,388 @@ int64_t fast_search(const fast_tree_t *tree, int32_t key)
     if (!tree || tree->n == 0)
         return -1;
 
+    if (tree->numa_replicated)
+        tree = fast_numa_route(tree);
+
     int64_t result;
-#if FAST_HAVE_SSE
-    fast_search_sse(tree, key, &result);
+    if (tree->compressed) {
+        fast_search_comp(tree, key, &result);
+    } else if (tree->force_scalar) {
+        fast_search_scalar(tree, key, &result);
+    } else {
+#if FAST_HAVE_AVX_DISPATCH
+        switch (tree->d_k) {
+        case FAST_DK_AVX512: fast_search_avx512(tree, key, &result); break;
+        case FAST_DK_AVX2:   fast_search_avx2(tree, key, &result);   break;
+        default:             fast_search_sse(tree, key, &result);    break;
+        }
+#elif FAST_HAVE_SSE
+        fast_search_sse(tree, key, &result);
+#elif FAST_HAVE_NEON
+#if FAST_HAVE_SVE
+        if (tree->d_k > FAST_DK)
+            fast_search_sve(tree, key, &result);
+        else
+#endif
+            fast_search_neon(tree, key, &result);
 #else
-    fast_search_scalar(tree, key, &result);
+        fast_search_scalar(tree, key, &result);
 #endif
+    }
+    /* Unmerged inserts shift every rank at or below them up by one. */
+    if (tree->delta_n)
+        result += (int64_t)fast_delta_count_le(tree, key);
     return result;
 }
 
+void fast_search_batch(const fast_tree_t *tree, const int32_t *queries,
+                       size_t m, int64_t *results)
+{
+    if (!tree || !queries || !results || m == 0)
+        return;
+
+    if (tree->n == 0) {
+        for (size_t i = 0; i < m; i++)
+            results[i] = -1;
+        return;
+    }
+
+    if (tree->numa_replicated)
+        tree = fast_numa_route(tree);
+
+    if (tree->compressed) {
+        for (size_t i = 0; i < m; i++)
+            fast_search_comp(tree, queries[i], &results[i]);
+    } else if (tree->force_scalar) {
+        for (size_t i = 0; i < m; i++)
+            fast_search_scalar(tree, queries[i], &results[i]);
+    } else {
+#if FAST_HAVE_SSE
+        fast_search_batch_sse(tree, queries, m, results);
+#elif FAST_HAVE_NEON
+        /* No pipelined cursor on AArch64 yet; per-query NEON/SVE. */
+        for (size_t i = 0; i < m; i++) {
+#if FAST_HAVE_SVE
+            if (tree->d_k > FAST_DK)
+                fast_search_sve(tree, queries[i], &results[i]);
+            else
+#endif
+                fast_search_neon(tree, queries[i], &results[i]);
+        }
+#else
+        for (size_t i = 0; i < m; i++)
+            fast_search_scalar(tree, queries[i], &results[i]);
+#endif
+    }
+
+    if (tree->delta_n) {
+        for (size_t i = 0; i < m; i++)
+            results[i] += (int64_t)fast_delta_count_le(tree, queries[i]);
+    }
+}
+
+void fast_search_lower_bound_batch(const fast_tree_t *tree,
+                                   const int32_t *queries, size_t m,
+                                   int64_t *results)
+{
+    if (!tree || !queries || !results || m == 0)
+        return;
+
+    if (tree->n == 0) {
+        for (size_t i = 0; i < m; i++)
+            results[i] = 0;
+        return;
+    }
+
+    if (tree->numa_replicated)
+        tree = fast_numa_route(tree);
+
+    if (tree->compressed || tree->force_scalar) {
+        /* The single-key entry point already covers these modes (and
+           folds in the delta buffer). */
+        for (size_t i = 0; i < m; i++)
+            results[i] = fast_search_lower_bound(tree, queries[i]);
+        return;
+    }
+
+#if FAST_HAVE_SSE
+    fast_lower_bound_batch_sse(tree, queries, m, results);
+#elif FAST_HAVE_NEON
+    /* No pipelined cursor on AArch64 yet; per-query NEON/SVE. */
+    for (size_t i = 0; i < m; i++) {
+#if FAST_HAVE_SVE
+        if (tree->d_k > FAST_DK)
+            fast_lower_bound_sve(tree, queries[i], &results[i]);
+        else
+#endif
+            fast_lower_bound_neon(tree, queries[i], &results[i]);
+    }
+#else
+    for (size_t i = 0; i < m; i++)
+        fast_lower_bound_scalar(tree, queries[i], &results[i]);
+#endif
+
+    if (tree->delta_n) {
+        for (size_t i = 0; i < m; i++)
+            results[i] += (int64_t)fast_delta_count_lt(tree, queries[i]);
+    }
+}
+
 int64_t fast_search_lower_bound(const fast_tree_t *tree, int32_t key)
 {
     if (!tree || tree->n == 0)
         return 0;
 
-    /* Lower bound: first key >= query.
-       Use the sorted keys array with binary search. */
-    const int32_t *keys = tree->keys;
+    if (tree->numa_replicated)
+        tree = fast_numa_route(tree);
+
+    int64_t lb;
+    if (tree->compressed) {
+        /* No int32 layout to descend; binary search the key array. */
+        const int32_t *keys = tree->keys;
+        size_t n = tree->n;
+        if (key <= keys[0]) {
+            lb = 0;
+        } else if (key > keys[n - 1]) {
+            lb = (int64_t)n;
+        } else {
+            size_t lo = 0, hi = n - 1;
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (keys[mid] < key)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            lb = (int64_t)lo;
+        }
+    } else if (tree->force_scalar) {
+        fast_lower_bound_scalar(tree, key, &lb);
+    } else {
+#if FAST_HAVE_AVX_DISPATCH
+        switch (tree->d_k) {
+        case FAST_DK_AVX512: fast_lower_bound_avx512(tree, key, &lb); break;
+        case FAST_DK_AVX2:   fast_lower_bound_avx2(tree, key, &lb);   break;
+        default:             fast_lower_bound_sse(tree, key, &lb);    break;
+        }
+#elif FAST_HAVE_SSE
+        fast_lower_bound_sse(tree, key, &lb);
+#elif FAST_HAVE_NEON
+#if FAST_HAVE_SVE
+        if (tree->d_k > FAST_DK)
+            fast_lower_bound_sve(tree, key, &lb);
+        else
+#endif
+            fast_lower_bound_neon(tree, key, &lb);
+#else
+        fast_lower_bound_scalar(tree, key, &lb);
+#endif
+    }
+    if (tree->delta_n)
+        lb += (int64_t)fast_delta_count_lt(tree, key);
+    return lb;
+}
+
+/*
+ * Coroutine-style begin/step entry points.  The resumable descent is
+ * the same fast_cursor the batch pipeline uses; here each caller owns
+ * one frame and the event loop supplies the interleaving that
+ * batch_pipeline's round-robin provides internally.  The delta-buffer
+ * rank adjustment is applied exactly once, at the moment the cursor
+ * completes, against the routed replica the cursor descended.
+ */
+static void cursor_begin(const fast_tree_t *tree, int32_t key,
+                         fast_cursor_t *cur, int lb)
+{
+    if (!cur)
+        return;
+    cur->tree = NULL;
+    cur->key = key;
+    cur->lb = lb;
+    cur->done = 1;
+
+    if (!tree || tree->n == 0) {
+        cur->result = lb ? 0 : -1;
+        return;
+    }
+
+#if FAST_HAVE_SSE
+    if (!tree->compressed && !tree->force_scalar) {
+        const fast_tree_t *t =
+            tree->numa_replicated ? fast_numa_route(tree) : tree;
+        cur->tree = t;
+        fast_cursor_init(t, cur, key, lb);
+        if (!cur->done) {
+            /* One block now, so the suspend already covers the first
+               memory round trip of the descent. */
+            fast_cursor_step(t, cur);
+        }
+        if (cur->done) {
+            cur->tree = NULL;
+            if (t->delta_n)
+                cur->result += (int64_t)(lb ? fast_delta_count_lt(t, key)
+                                            : fast_delta_count_le(t, key));
+        }
+        return;
+    }
+#endif
+
+    /* No resumable descent for this mode; the single-key entry points
+       cover it (and fold in the delta buffer). */
+    cur->result = lb ? fast_search_lower_bound(tree, key)
+                     : fast_search(tree, key);
+}
+
+void fast_search_begin(const fast_tree_t *tree, int32_t key,
+                       fast_cursor_t *cursor)
+{
+    cursor_begin(tree, key, cursor, 0);
+}
+
+void fast_lower_bound_begin(const fast_tree_t *tree, int32_t key,
+                            fast_cursor_t *cursor)
+{
+    cursor_begin(tree, key, cursor, 1);
+}
+
+int fast_search_step(fast_cursor_t *cursor)
+{
+    if (!cursor || cursor->done)
+        return 1;
+
+#if FAST_HAVE_SSE
+    {
+        const fast_tree_t *t = cursor->tree;
+        fast_cursor_step(t, cursor);
+        if (!cursor->done)
+            return 0;
+        cursor->tree = NULL;
+        if (t->delta_n)
+            cursor->result +=
+                (int64_t)(cursor->lb
+                              ? fast_delta_count_lt(t, cursor->key)
+                              : fast_delta_count_le(t, cursor->key));
+    }
+#endif
+    return 1;
+}
+
+size_t fast_size(const fast_tree_t *tree)
+{
+    return tree ? tree->n + tree->delta_n : 0;
+}
+
+int32_t fast_key_at(const fast_tree_t *tree, size_t index)
+{
+    if (!tree || index >= tree->n + tree->delta_n)
+        return 0;
+    if (tree->delta_n)
+        return fast_merged_key_at(tree, index);
+    return tree->keys[index];
+}
+
+size_t fast_range_count(const fast_tree_t *tree, int32_t lo, int32_t hi)
+{
+    if (!tree || tree->n == 0 || lo > hi)
+        return 0;
+
+    /* First key >= lo, last key <= hi */
+    int64_t first = fast_search_lower_bound(tree, lo);
+    int64_t last = fast_search(tree, hi);
+
+    if (first >= (int64_t)fast_size(tree) || last < first)
+        return 0;
+    return (size_t)(last - first + 1);
+}
+
+size_t fast_range_copy(const fast_tree_t *tree, int32_t lo, int32_t hi,
+                       int32_t *out, size_t max)
+{
+    if (!tree || tree->n == 0 || !out || lo > hi)
+        return 0;
+
+    if (tree->delta_n)
+        return fast_merged_range_copy(tree, lo, hi, out, max);
+
+    int64_t first = fast_search_lower_bound(tree, lo);
+    int64_t last = fast_search(tree, hi);
+
+    if (first >= (int64_t)tree->n || last < first)
+        return 0;
+
+    size_t count = (size_t)(last - first + 1);
+    if (count > max)
+        count = max;
+    memcpy(out, tree->keys + first, count * sizeof(int32_t));
+    return count;
+}
+
+const int32_t *fast_keys_ptr(const fast_tree_t *tree)
+{
+    return tree ? tree->keys : NULL;
+}
+
+fast64_tree_t *fast64_create(const int64_t *keys, size_t n)
+{
+    if (!keys || n == 0)
+        return NULL;
+
+    struct fast64_tree *t =
+        (struct fast64_tree *)calloc(1, sizeof(struct fast64_tree));
+    if (!t)
+        return NULL;
+
+    t->build_threads = 1;
+    t->compact = 1;  /* ranks always come from the descent path */
+    t->prefetch = fast_env_prefetch();
+    fast64_pick_simd_width(t);
+
+    if (fast64_build_layout(t, keys, n) != 0) {
+        free(t);
+        return NULL;
+    }
+
+    return t;
+}
+
+void fast64_destroy(fast64_tree_t *tree)
+{
+    if (!tree)
+        return;
+
+    if (tree->layout_map)
+        munmap(tree->layout_map, tree->layout_map_bytes);
+    else
+        free(tree->layout);
+    free(tree->sorted_rank);
+    free(tree->keys);
+    free(tree);
+}
+
+int64_t fast64_search(const fast64_tree_t *tree, int64_t key)
+{
+    if (!tree || tree->n == 0)
+        return -1;
+
+    int64_t result;
+#if FAST_HAVE_AVX_DISPATCH
+    switch (tree->d_k) {
+    case FAST64_DK_AVX512: fast64_search_avx512(tree, key, &result); break;
+    case FAST64_DK_AVX2:   fast64_search_avx2(tree, key, &result);   break;
+    default:               fast64_search_scalar(tree, key, &result); break;
+    }
+#else
+    fast64_search_scalar(tree, key, &result);
+#endif
+    return result;
+}
+
+int64_t fast64_search_lower_bound(const fast64_tree_t *tree, int64_t key)
+{
+    if (!tree || tree->n == 0)
+        return 0;
+
+    const int64_t *keys = tree->keys;
     size_t n = tree->n;
 
     if (key <= keys[0])
@@ -68,12 +794,12 @@ int64_t fast_search_lower_bound(const fast_tree_t *tree, int32_t key)
     return (int64_t)lo;
 }
 
-size_t fast_size(const fast_tree_t *tree)
+size_t fast64_size(const fast64_tree_t *tree)
 {
     return tree ? tree->n : 0;
 }
 
-int32_t fast_key_at(const fast_tree_t *tree, size_t index)
+int64_t fast64_key_at(const fast64_tree_t *tree, size_t index)
 {
     if (!tree || index >= tree->n)
         return 0;
@@ -0,0 +1,75 @@
+/*
+ * Arena allocator for fast_create_in.
+ *
+ * Startup workloads that build tens of thousands of small per-shard
+ * trees spend more time in the allocator than in the layout code.  An
+ * arena turns that into one malloc for its lifetime: persistent tree
+ * data bumps up from the bottom of the slab, build scratch bumps down
+ * from the top and is rewound after each build, and resetting the
+ * arena reclaims every tree built in it at once.
+ *
+ * Persistent allocations are 64-byte aligned so the layout keeps its
+ * cache line (and wide-load padding) guarantees inside the slab.
+ */
+
+#include "fast_internal.h"
+
+#define FAST_ARENA_ALIGN 64
+
+fast_arena_t *fast_arena_create(size_t bytes)
+{
+    if (bytes < sizeof(struct fast_arena) + FAST_ARENA_ALIGN)
+        return NULL;
+
+    /* The slab itself must be 64-byte aligned: the bump pointers only
+       guarantee slab-relative alignment, so a merely malloc-aligned
+       slab would leave every allocation off by the slab's own skew. */
+    void *mem = NULL;
+    if (posix_memalign(&mem, FAST_ARENA_ALIGN, bytes) != 0)
+        return NULL;
+    unsigned char *slab = (unsigned char *)mem;
+
+    /* The arena header occupies the bottom of its own slab. */
+    struct fast_arena *a = (struct fast_arena *)slab;
+    a->base = slab;
+    a->cap = bytes;
+    a->lo = (sizeof(struct fast_arena) + FAST_ARENA_ALIGN - 1) &
+            ~((size_t)FAST_ARENA_ALIGN - 1);
+    a->hi = bytes;
+    return a;
+}
+
+void fast_arena_reset(fast_arena_t *arena)
+{
+    if (!arena)
+        return;
+    arena->lo = (sizeof(struct fast_arena) + FAST_ARENA_ALIGN - 1) &
+                ~((size_t)FAST_ARENA_ALIGN - 1);
+    arena->hi = arena->cap;
+}
+
+void fast_arena_destroy(fast_arena_t *arena)
+{
+    free(arena);
+}
+
+void *fast_arena_lo_alloc(struct fast_arena *a, size_t bytes)
+{
+    size_t take = (bytes + FAST_ARENA_ALIGN - 1) &
+                  ~((size_t)FAST_ARENA_ALIGN - 1);
+    if (take < bytes || take > a->hi - a->lo)
+        return NULL;
+    void *p = a->base + a->lo;
+    a->lo += take;
+    return p;
+}
+
+void *fast_arena_hi_alloc(struct fast_arena *a, size_t bytes)
+{
+    size_t take = (bytes + FAST_ARENA_ALIGN - 1) &
+                  ~((size_t)FAST_ARENA_ALIGN - 1);
+    if (take < bytes || take > a->hi - a->lo)
+        return NULL;
+    a->hi -= take;
+    return a->base + a->hi;
+}
@@ -1,128 +1,51 @@
 #include "fast_internal.h"
 
-/*
- * Build a mapping from sorted index -> BFS index for a complete binary
- * tree with `n` nodes.  sorted_to_bfs[i] = BFS index (0-based) for the
- * i-th smallest key.
- *
- * We do an in-order traversal of the implicit complete binary tree
- * (0-indexed BFS layout) to assign sorted positions.
- */
-static void build_inorder_map(size_t *bfs_to_sorted, size_t n)
-{
-    /* In-order traversal of implicit complete binary tree.
-     * BFS index i (0-based): left child = 2i+1, right child = 2i+2.
-     * We traverse in-order and assign consecutive sorted indices. */
-    size_t sorted_idx = 0;
-
-    /* Iterative in-order traversal using a stack. */
-    size_t *stack = (size_t *)malloc(64 * sizeof(size_t));
-    size_t stack_cap = 64;
-    size_t stack_top = 0;
-    size_t cur = 0;
+#include <pthread.h>
+#include <sys/mman.h>
 
-    while (cur < n || stack_top > 0) {
-        while (cur < n) {
-            if (stack_top >= stack_cap) {
-                stack_cap *= 2;
-                stack = (size_t *)realloc(stack, stack_cap * sizeof(size_t));
-            }
-            stack[stack_top++] = cur;
-            cur = 2 * cur + 1;  /* left child */
-        }
-        if (stack_top > 0) {
-            cur = stack[--stack_top];
-            bfs_to_sorted[cur] = sorted_idx++;
-            cur = 2 * cur + 2;  /* right child */
-        }
-    }
-
-    free(stack);
-}
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB 0x40000
+#endif
 
 /*
- * Recursively lay out the hierarchically blocked tree.
- *
- * This is the core of the FAST layout algorithm. We recursively decompose
- * the BFS-ordered binary tree into blocks at three granularities:
- *
- * 1. SIMD blocks: d_K=2 levels, N_K=3 nodes
- *    A complete binary subtree of depth 2 (root + 2 children).
- *    Fits in one SSE register load (3 × 4 bytes = 12 bytes).
- *
- * 2. Cache line blocks: d_L=4 levels, N_L=15 nodes
- *    Contains ceil(d_L/d_K) = 2 "rounds" of SIMD blocks.
- *    First SIMD block (3 nodes) at the top, then 4 child SIMD blocks
- *    (12 nodes) = 15 total. Fits in one 64-byte cache line (60 bytes).
- *
- * 3. Page blocks: d_P levels, N_P nodes
- *    Contains ceil(d_P/d_L) rounds of cache line blocks.
+ * Hierarchically blocked layout construction.
  *
- * The layout procedure:
- *   layout_block(bfs_tree, out, bfs_root, out_pos, remaining_depth, block_type)
+ * This is the core of the FAST layout algorithm.  We recursively
+ * decompose the BFS-ordered binary tree into blocks at up to four
+ * granularities (SIMD / cache line / page / superpage): for a subtree,
+ * write its top block_depth levels as one block, then recursively lay
+ * out each child subtree.  Within a block the next finer blocking level
+ * applies, so a cache line block's nodes are themselves arranged as
+ * SIMD blocks, and so on.
  *
- * For a subtree of `depth` levels rooted at BFS index `bfs_root`:
- *   - Extract the top `block_depth` levels (the current block)
- *   - Write those nodes contiguously at `out_pos`
- *   - Recursively lay out each child subtree
+ * The blocking arithmetic never looks at a key, so the builder proper
+ * lives in fast_build_impl.h as a type-parameterized template and is
+ * instantiated below once per key width (fast_build_layout for int32_t,
+ * fast64_build_layout for int64_t).  The helpers here are shared.
  */
 
+#define FAST_PASTE_(a, b) a##b
+#define FAST_PASTE(a, b) FAST_PASTE_(a, b)
+
 /*
- * Write a complete binary subtree of `depth` levels rooted at `bfs_root`
- * in BFS order into `out` starting at `out_pos`.
- * Returns the number of nodes written (2^depth - 1).
+ * In-order rank of BFS node `bfs` in a complete binary tree of `d_n`
+ * levels, computed arithmetically: a node at level l (0-based from the
+ * root), position p within its level, roots a subtree of height
+ * h = d_n - l, and its in-order rank is p * 2^h + 2^(h-1) - 1.
+ * This replaces the explicit-stack in-order traversal the build used
+ * to materialize, and makes every node's rank independently computable
+ * (which is what allows subtrees to be laid out in parallel).
  */
-static size_t write_bfs_block(const int32_t *bfs_tree, int32_t *out,
-                              int32_t *sorted_rank_out,
-                              const size_t *bfs_to_sorted, size_t n_keys,
-                              size_t bfs_root, size_t out_pos,
-                              int depth, size_t total_bfs_nodes)
+static inline size_t bfs_inorder_rank(size_t bfs, int d_n)
 {
-    size_t count = 0;
-    size_t block_size = ((size_t)1 << depth) - 1;
-
-    /* BFS traversal of the subtree: level by level */
-    size_t *queue = (size_t *)malloc(block_size * sizeof(size_t));
-    size_t head = 0, tail = 0;
-
-    if (bfs_root < total_bfs_nodes) {
-        queue[tail++] = bfs_root;
-    }
-
-    int levels_done = 0;
-    size_t level_remaining = 1;
-    size_t next_level_count = 0;
-
-    while (head < tail && levels_done < depth) {
-        size_t node = queue[head++];
-        level_remaining--;
-
-        out[out_pos + count] = bfs_tree[node];
-        /* Map layout position to sorted index; sentinel nodes get n_keys */
-        size_t si = bfs_to_sorted[node];
-        sorted_rank_out[out_pos + count] = (si < n_keys) ? (int32_t)si : (int32_t)n_keys;
-        count++;
-
-        size_t left = 2 * node + 1;
-        size_t right = 2 * node + 2;
-        if (left < total_bfs_nodes && levels_done + 1 < depth) {
-            queue[tail++] = left;
-            next_level_count++;
-        }
-        if (right < total_bfs_nodes && levels_done + 1 < depth) {
-            queue[tail++] = right;
-            next_level_count++;
-        }
-
-        if (level_remaining == 0) {
-            levels_done++;
-            level_remaining = next_level_count;
-            next_level_count = 0;
-        }
-    }
-
-    free(queue);
-    return count;
+    size_t v = bfs + 1;
+    int level = 0;
+    while (v >>= 1)
+        level++;
+
+    size_t pos = bfs + 1 - ((size_t)1 << level);
+    int h = d_n - level;
+    return pos * (((size_t)1) << h) + (((size_t)1) << (h - 1)) - 1;
 }
 
 /*
@@ -155,225 +78,182 @@ static size_t collect_children(size_t bfs_root, int depth,
     return count;
 }
 
-/*
- * Recursively lay out a subtree in the hierarchical blocked fashion.
- *
- * blocking_level:
- *   0 = we're laying out SIMD blocks (innermost, d_K levels)
- *   1 = cache line blocks (d_L levels, decomposed into SIMD blocks)
- *   2 = page blocks (d_P levels, decomposed into cache line blocks)
- *   3 = top level (whole tree, decomposed into page blocks)
- *
- * For each level, we:
- *   1. Write the top `sub_depth` levels of the current subtree
- *   2. Collect the child subtree roots
- *   3. Recursively lay out each child
- *
- * The sub_depth at each blocking level:
- *   - Level 0 (SIMD):       sub_depth = d_K = 2
- *   - Level 1 (cache line): sub_depth = d_L = 4 (contains SIMD blocks internally)
- *   - Level 2 (page):       sub_depth = d_P (contains cache line blocks)
- *
- * But we want the *within-block* layout to also be hierarchical. So a cache
- * line block's 15 nodes are arranged as: [3 SIMD-block nodes] followed by
- * [4 child SIMD blocks of 3 nodes each].  Similarly for page blocks.
- *
- * We implement this with a two-phase approach:
- * Phase 1: Build BFS tree from sorted keys
- * Phase 2: Permute into blocked layout via recursive decomposition
- */
+/* 32-bit instantiation (fast_build_layout and helpers) */
+#define FAST_IMPL_PREFIX   fast
+#define FAST_IMPL_KEY      int32_t
+#define FAST_IMPL_KEY_MAX  FAST_KEY_MAX
+#define FAST_IMPL_TREE     struct fast_tree
+#define FAST_IMPL_DK       FAST_DK
+#define FAST_IMPL_DL       FAST_DL
+#include "fast_build_impl.h"
+#undef FAST_IMPL_PREFIX
+#undef FAST_IMPL_KEY
+#undef FAST_IMPL_KEY_MAX
+#undef FAST_IMPL_TREE
+#undef FAST_IMPL_DK
+#undef FAST_IMPL_DL
+
+/* 64-bit instantiation (fast64_build_layout and helpers) */
+#define FAST_IMPL_PREFIX   fast64
+#define FAST_IMPL_KEY      int64_t
+#define FAST_IMPL_KEY_MAX  FAST_KEY64_MAX
+#define FAST_IMPL_TREE     struct fast64_tree
+#define FAST_IMPL_DK       FAST64_DK
+#define FAST_IMPL_DL       FAST64_DL
+#include "fast_build_impl.h"
+#undef FAST_IMPL_PREFIX
+#undef FAST_IMPL_KEY
+#undef FAST_IMPL_KEY_MAX
+#undef FAST_IMPL_TREE
+#undef FAST_IMPL_DK
+#undef FAST_IMPL_DL
 
 /*
- * lay_out_subtree: Recursively arrange a subtree rooted at BFS index
- * `bfs_root` (with `remaining_depth` levels below it) into the output
- * array at position `*out_pos`.
- *
- * `block_depth` is the depth of the current blocking level we should
- * decompose into (d_K for SIMD, d_L for cache-line, d_P for page).
- *
- * `blocking_level`: 0=SIMD, 1=cacheline, 2=page
- * `depths`: array [d_K, d_L, d_P]
+ * Parallel LSD radix sort for the unsorted-ingest path
+ * (fast_create_unsorted).  Four 8-bit passes; the top byte is XORed
+ * with 0x80 so two's-complement order matches unsigned bucket order.
+ * Each pass histograms the key chunks in parallel, prefix-sums the
+ * per-thread counts into per-thread scatter offsets, then scatters in
+ * parallel.  Chunks are assigned in array order, so the stable
+ * per-chunk scatter is globally stable and the stripes write disjoint
+ * output ranges — the same no-synchronization shape as the parallel
+ * layout build above.  A pass whose byte is constant across all keys
+ * moves nothing and is skipped, so narrow key ranges sort in one or
+ * two passes.
  */
-static void lay_out_subtree(const int32_t *bfs_tree, int32_t *out,
-                            int32_t *sorted_rank_out,
-                            const size_t *bfs_to_sorted, size_t n_keys,
-                            size_t bfs_root, size_t *out_pos,
-                            int remaining_depth, int blocking_level,
-                            const int *depths, size_t total_bfs_nodes)
-{
-    if (remaining_depth <= 0 || bfs_root >= total_bfs_nodes)
-        return;
-
-    int block_depth = depths[blocking_level];
-
-    if (remaining_depth <= block_depth || blocking_level == 0) {
-        int actual_depth = remaining_depth < block_depth ? remaining_depth : block_depth;
-        size_t written = write_bfs_block(bfs_tree, out, sorted_rank_out,
-                                         bfs_to_sorted, n_keys,
-                                         bfs_root, *out_pos,
-                                         actual_depth, total_bfs_nodes);
-        *out_pos += written;
-
-        if (remaining_depth > block_depth) {
-            size_t children[1 << FAST_DK];
-            size_t nchildren = collect_children(bfs_root, actual_depth,
-                                                children, total_bfs_nodes);
-            for (size_t i = 0; i < nchildren; i++) {
-                lay_out_subtree(bfs_tree, out, sorted_rank_out,
-                                bfs_to_sorted, n_keys,
-                                children[i], out_pos,
-                                remaining_depth - actual_depth, blocking_level,
-                                depths, total_bfs_nodes);
-            }
-        }
-    } else {
-        lay_out_subtree(bfs_tree, out, sorted_rank_out,
-                        bfs_to_sorted, n_keys,
-                        bfs_root, out_pos,
-                        block_depth, blocking_level - 1,
-                        depths, total_bfs_nodes);
-
-        size_t max_children = (size_t)1 << block_depth;
-        size_t *children = (size_t *)malloc(max_children * sizeof(size_t));
-        size_t nchildren = collect_children(bfs_root, block_depth,
-                                            children, total_bfs_nodes);
 
-        for (size_t i = 0; i < nchildren; i++) {
-            lay_out_subtree(bfs_tree, out, sorted_rank_out,
-                            bfs_to_sorted, n_keys,
-                            children[i], out_pos,
-                            remaining_depth - block_depth, blocking_level,
-                            depths, total_bfs_nodes);
-        }
-        free(children);
-    }
+struct fast_radix_task {
+    const int32_t *src;
+    int32_t *dst;
+    size_t lo, hi;
+    size_t count[256];
+    size_t offset[256];
+    int shift;
+    int phase;            /* 0 = histogram, 1 = scatter */
+    int started;
+};
+
+static inline unsigned radix_byte(int32_t key, int shift)
+{
+    unsigned b = ((uint32_t)key >> shift) & 0xffu;
+    return (shift == 24) ? (b ^ 0x80u) : b;
 }
 
-int fast_build_layout(struct fast_tree *t, const int32_t *sorted_keys, size_t n)
+static void *fast_radix_worker(void *arg)
 {
-    /* Compute tree depth: d_N = ceil(log2(n+1)) so that 2^d_N - 1 >= n */
-    int d_n = 0;
-    {
-        size_t tmp = 1;
-        while (tmp - 1 < n) { d_n++; tmp <<= 1; }
-    }
-    size_t tree_nodes = ((size_t)1 << d_n) - 1;
-
-    t->d_n = d_n;
-    t->tree_nodes = tree_nodes;
-    t->n = n;
+    struct fast_radix_task *task = (struct fast_radix_task *)arg;
 
-    /* Detect page size */
-    long ps = sysconf(_SC_PAGESIZE);
-    t->page_size = (ps > 0) ? (size_t)ps : 4096;
-    /* Compute d_p: largest d such that (2^d - 1) * 4 <= page_size */
-    t->d_p = FAST_DP_4K;
-    if (t->page_size >= 2 * 1024 * 1024) {
-        t->d_p = FAST_DP_2M;
+    if (task->phase == 0) {
+        memset(task->count, 0, sizeof(task->count));
+        for (size_t i = task->lo; i < task->hi; i++)
+            task->count[radix_byte(task->src[i], task->shift)]++;
     } else {
-        int dp = 1;
-        while (((size_t)1 << (dp + 1)) - 1 <= t->page_size / sizeof(int32_t)) {
-            dp++;
+        for (size_t i = task->lo; i < task->hi; i++) {
+            unsigned b = radix_byte(task->src[i], task->shift);
+            task->dst[task->offset[b]++] = task->src[i];
         }
-        t->d_p = dp;
     }
-    t->n_p = ((size_t)1 << t->d_p) - 1;
-
-    /* Copy sorted keys */
-    t->keys = (int32_t *)malloc(n * sizeof(int32_t));
-    if (!t->keys)
-        return -1;
-    memcpy(t->keys, sorted_keys, n * sizeof(int32_t));
+    return NULL;
+}
 
-    /* Build BFS tree: bfs_tree[i] holds the key at BFS position i */
-    int32_t *bfs_tree = (int32_t *)malloc(tree_nodes * sizeof(int32_t));
-    if (!bfs_tree) {
-        free(t->keys);
-        t->keys = NULL;
-        return -1;
+static void fast_radix_phase(struct fast_radix_task *tasks, pthread_t *tids,
+                             int nthreads, int phase)
+{
+    for (int w = 0; w < nthreads; w++)
+        tasks[w].phase = phase;
+    for (int w = 0; w + 1 < nthreads; w++) {
+        tasks[w].started = (pthread_create(&tids[w], NULL,
+                                           fast_radix_worker,
+                                           &tasks[w]) == 0);
+        if (!tasks[w].started)
+            fast_radix_worker(&tasks[w]);     /* degrade to inline */
     }
-
-    /* Fill with sentinel, then populate via in-order mapping */
-    for (size_t i = 0; i < tree_nodes; i++)
-        bfs_tree[i] = FAST_KEY_MAX;
-
-    /* Build mapping: bfs_to_sorted[bfs_index] = sorted_index */
-    size_t *bfs_to_sorted = (size_t *)malloc(tree_nodes * sizeof(size_t));
-    if (!bfs_to_sorted) {
-        free(bfs_tree);
-        free(t->keys);
-        t->keys = NULL;
-        return -1;
+    fast_radix_worker(&tasks[nthreads - 1]);
+    for (int w = 0; w + 1 < nthreads; w++) {
+        if (tasks[w].started)
+            pthread_join(tids[w], NULL);
     }
-    for (size_t i = 0; i < tree_nodes; i++)
-        bfs_to_sorted[i] = SIZE_MAX;
-
-    build_inorder_map(bfs_to_sorted, tree_nodes);
+}
 
-    /* Populate BFS tree: for each BFS node, assign the key at its
-       in-order rank (or sentinel if rank >= n) */
-    for (size_t i = 0; i < tree_nodes; i++) {
-        size_t sorted_idx = bfs_to_sorted[i];
-        if (sorted_idx < n)
-            bfs_tree[i] = sorted_keys[sorted_idx];
-        else
-            bfs_tree[i] = FAST_KEY_MAX;
+/*
+ * Sort `src` into the caller-owned `dst` (both of length n).  Sorted
+ * input is detected with one cheap scan and degrades to a memcpy.
+ * Returns 0, or -1 if the ping-pong buffer could not be allocated.
+ */
+int fast_sort_into(int32_t *dst, const int32_t *src, size_t n, int nthreads)
+{
+    size_t i = 1;
+    while (i < n && src[i - 1] <= src[i])
+        i++;
+    if (i >= n) {
+        memcpy(dst, src, n * sizeof(int32_t));
+        return 0;
     }
-    /* Allocate output layout array (aligned to page boundary for TLB perf) */
-    size_t layout_bytes = tree_nodes * sizeof(int32_t);
-    /* Round up to multiple of 64 (cache line) and add padding for SSE loads */
-    layout_bytes = ((layout_bytes + 63) / 64) * 64 + 16;
-    size_t layout_elems = layout_bytes / sizeof(int32_t);
 
-    t->layout = NULL;
-    if (posix_memalign((void **)&t->layout, t->page_size > 64 ? 4096 : 64,
-                       layout_bytes) != 0) {
-        free(bfs_to_sorted);
-        free(bfs_tree);
-        free(t->keys);
-        t->keys = NULL;
+    if (nthreads < 1)
+        nthreads = 1;
+    /* Don't spin up threads for chunks too small to amortize them. */
+    while (nthreads > 1 && n / (size_t)nthreads < 16384)
+        nthreads--;
+
+    int32_t *aux = (int32_t *)malloc(n * sizeof(int32_t));
+    struct fast_radix_task *tasks = (struct fast_radix_task *)
+        malloc((size_t)nthreads * sizeof(struct fast_radix_task));
+    pthread_t *tids = (pthread_t *)
+        malloc((size_t)nthreads * sizeof(pthread_t));
+    if (!aux || !tasks || !tids) {
+        free(aux);
+        free(tasks);
+        free(tids);
         return -1;
     }
 
-    /* Allocate sorted_rank array (same size as layout) */
-    t->sorted_rank = (int32_t *)malloc(layout_bytes);
-    if (!t->sorted_rank) {
-        free(t->layout);
-        t->layout = NULL;
-        free(bfs_to_sorted);
-        free(bfs_tree);
-        free(t->keys);
-        t->keys = NULL;
-        return -1;
-    }
-    t->layout_size = layout_elems;
+    /* The first real pass scatters src into dst, fusing the copy the
+       caller would otherwise pay; later passes ping-pong dst <-> aux. */
+    const int32_t *from = src;
+    int32_t *to = dst;
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        for (int w = 0; w < nthreads; w++) {
+            tasks[w].src = from;
+            tasks[w].dst = to;
+            tasks[w].lo = n * (size_t)w / (size_t)nthreads;
+            tasks[w].hi = n * (size_t)(w + 1) / (size_t)nthreads;
+            tasks[w].shift = shift;
+        }
+        fast_radix_phase(tasks, tids, nthreads, 0);
+
+        /* Skip the scatter when every key lands in one bucket. */
+        int trivial = 0;
+        for (int b = 0; b < 256 && !trivial; b++) {
+            size_t total = 0;
+            for (int w = 0; w < nthreads; w++)
+                total += tasks[w].count[b];
+            trivial = (total == n);
+        }
+        if (trivial)
+            continue;
+
+        size_t running = 0;
+        for (int b = 0; b < 256; b++) {
+            for (int w = 0; w < nthreads; w++) {
+                tasks[w].offset[b] = running;
+                running += tasks[w].count[b];
+            }
+        }
+        fast_radix_phase(tasks, tids, nthreads, 1);
 
-    /* Fill layout with sentinel, sorted_rank with n (invalid) */
-    for (size_t i = 0; i < layout_elems; i++) {
-        t->layout[i] = FAST_KEY_MAX;
-        t->sorted_rank[i] = (int32_t)n;
+        from = to;
+        to = (to == dst) ? aux : dst;
     }
 
-    /* Perform SIMD-blocked layout.
-     *
-     * We use blocking_level=0 (SIMD only) which writes 3-node BFS blocks
-     * with their 4 child subtrees contiguous.  This matches the search
-     * traversal's offset computation: after each 3-key SIMD block,
-     * child i's subtree is at offset + 3 + i * child_subtree_size.
-     *
-     * Cache-line and page blocking (levels 1, 2) would require a search
-     * that tracks nested block offsets; for now SIMD blocking provides
-     * correctness and the main performance benefit (SSE comparisons).
-     */
-    int depths[3] = { FAST_DK, FAST_DL, t->d_p };
-
-    size_t out_pos = 0;
-    lay_out_subtree(bfs_tree, t->layout, t->sorted_rank,
-                    bfs_to_sorted, n,
-                    0, &out_pos, d_n, 0,
-                    depths, tree_nodes);
+    /* The pre-scan rejected sorted input, so at least one scatter ran
+       and `from` holds the result; it is aux after an odd number. */
+    if (from == aux)
+        memcpy(dst, aux, n * sizeof(int32_t));
 
-    free(bfs_to_sorted);
-    free(bfs_tree);
+    free(tids);
+    free(tasks);
+    free(aux);
     return 0;
 }
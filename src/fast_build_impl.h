@@ -0,0 +1,551 @@
+/*
+ * Type-parameterized layout builder, included once per key width by
+ * fast_build.c.  The blocking arithmetic is identical for any key size;
+ * only the element type, the padding sentinel and the derived blocking
+ * depths differ.  The includer must define:
+ *
+ *   FAST_IMPL_PREFIX   symbol prefix (fast / fast64)
+ *   FAST_IMPL_KEY      key type (int32_t / int64_t)
+ *   FAST_IMPL_KEY_MAX  sentinel for padding nodes
+ *   FAST_IMPL_TREE     tree struct (field-compatible with fast_tree)
+ *   FAST_IMPL_DK       default SIMD blocking depth when d_k is unset
+ *   FAST_IMPL_DL       default cache line blocking depth
+ *
+ * and undefine them afterwards.  Shared helpers (bfs_inorder_rank,
+ * collect_children) live in fast_build.c and are width-independent.
+ */
+
+#define FAST_IMPL(name) FAST_PASTE(FAST_IMPL_PREFIX, name)
+
+/*
+ * Allocate the layout array.  In hugepage mode (fast_create_huge) we
+ * try, in order: an explicit MAP_HUGETLB mapping (fails unless the
+ * system has hugepages reserved), a normal anonymous mapping with
+ * MADV_HUGEPAGE (transparent hugepages, best effort), and finally the
+ * regular posix_memalign path.  An mmap-backed layout records the
+ * mapping so the destructor can munmap instead of free.
+ */
+static int FAST_IMPL(_alloc_layout)(FAST_IMPL_TREE *t, size_t layout_bytes)
+{
+    t->layout = NULL;
+    t->layout_map = NULL;
+    t->layout_map_bytes = 0;
+
+    if (t->arena) {
+        t->layout = (FAST_IMPL_KEY *)fast_arena_lo_alloc(t->arena,
+                                                         layout_bytes);
+        return t->layout ? 0 : -1;
+    }
+
+    if (t->want_huge) {
+        size_t map_bytes = (layout_bytes + FAST_SUPERPAGE_BYTES - 1) &
+                           ~((size_t)FAST_SUPERPAGE_BYTES - 1);
+        void *p = mmap(NULL, map_bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p == MAP_FAILED) {
+            p = mmap(NULL, map_bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+            if (p != MAP_FAILED)
+                madvise(p, map_bytes, MADV_HUGEPAGE);
+#endif
+        }
+        if (p != MAP_FAILED) {
+            t->layout = (FAST_IMPL_KEY *)p;
+            t->layout_map = p;
+            t->layout_map_bytes = map_bytes;
+            return 0;
+        }
+        /* No hugepage backing available; fall through */
+    }
+
+    if (posix_memalign((void **)&t->layout,
+                       t->page_size > 64 ? 4096 : 64, layout_bytes) != 0) {
+        t->layout = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static void FAST_IMPL(_free_layout)(FAST_IMPL_TREE *t)
+{
+    if (t->arena)
+        ;  /* arena memory is reclaimed only by reset/destroy */
+    else if (t->layout_map)
+        munmap(t->layout_map, t->layout_map_bytes);
+    else
+        free(t->layout);
+    t->layout = NULL;
+    t->layout_map = NULL;
+    t->layout_map_bytes = 0;
+}
+
+/*
+ * Write a complete binary subtree of `depth` levels rooted at `bfs_root`
+ * in BFS order into `out` starting at `out_pos`.
+ * Returns the number of nodes written (2^depth - 1).
+ */
+static size_t FAST_IMPL(_write_bfs_block)(const FAST_IMPL_KEY *sorted_keys,
+                                          size_t n_keys, int d_n,
+                                          FAST_IMPL_KEY *out,
+                                          int32_t *sorted_rank_out,
+                                          size_t bfs_root, size_t out_pos,
+                                          int depth, size_t total_bfs_nodes)
+{
+    size_t count = 0;
+
+    /* BFS traversal of the subtree, level by level.  Only SIMD blocks
+       are written this way (depth <= FAST_DK_MAX + 1, counting folded
+       terminal blocks), so the queue fits on the stack and the inner
+       build loop never touches the allocator. */
+    size_t queue[((size_t)1 << (FAST_DK_MAX + 1)) - 1];
+    size_t head = 0, tail = 0;
+
+    if (bfs_root < total_bfs_nodes) {
+        queue[tail++] = bfs_root;
+    }
+
+    int levels_done = 0;
+    size_t level_remaining = 1;
+    size_t next_level_count = 0;
+
+    while (head < tail && levels_done < depth) {
+        size_t node = queue[head++];
+        level_remaining--;
+
+        /* Map layout position to sorted index; sentinel nodes get n_keys */
+        size_t si = bfs_inorder_rank(node, d_n);
+        out[out_pos + count] = (si < n_keys) ? sorted_keys[si]
+                                             : FAST_IMPL_KEY_MAX;
+        if (sorted_rank_out)
+            sorted_rank_out[out_pos + count] =
+                (si < n_keys) ? (int32_t)si : (int32_t)n_keys;
+        count++;
+
+        size_t left = 2 * node + 1;
+        size_t right = 2 * node + 2;
+        if (left < total_bfs_nodes && levels_done + 1 < depth) {
+            queue[tail++] = left;
+            next_level_count++;
+        }
+        if (right < total_bfs_nodes && levels_done + 1 < depth) {
+            queue[tail++] = right;
+            next_level_count++;
+        }
+
+        if (level_remaining == 0) {
+            levels_done++;
+            level_remaining = next_level_count;
+            next_level_count = 0;
+        }
+    }
+
+    return count;
+}
+
+/*
+ * lay_out_subtree: Recursively arrange a subtree rooted at BFS index
+ * `bfs_root` (with `remaining_depth` levels below it) into the output
+ * array at position `*out_pos`.
+ *
+ * `blocking_level`: 0=SIMD, 1=cacheline, 2=page, 3=superpage
+ * `depths`: array [d_K, d_L, d_P, d_P2]
+ *
+ * Returns 0, or -1 if child-list scratch could not be allocated (an
+ * arena running out of space mid-build, or a heap malloc failure on
+ * the parallel workers' scratch-free path).
+ */
+static int FAST_IMPL(_lay_out_subtree)(const FAST_IMPL_KEY *sorted_keys,
+                                       size_t n_keys, int d_n,
+                                       FAST_IMPL_KEY *out,
+                                       int32_t *sorted_rank_out,
+                                       size_t bfs_root, size_t *out_pos,
+                                       int remaining_depth, int blocking_level,
+                                       const int *depths,
+                                       size_t total_bfs_nodes,
+                                       struct fast_arena *scratch)
+{
+    if (remaining_depth <= 0 || bfs_root >= total_bfs_nodes)
+        return 0;
+
+    int block_depth = depths[blocking_level];
+
+    if (blocking_level == 0) {
+        /* A one-level remainder is folded into the preceding SIMD block
+           (depth d_K + 1) instead of becoming a single-key tail block;
+           the search kernels split the same way. */
+        int actual_depth = remaining_depth <= block_depth + 1
+                               ? remaining_depth : block_depth;
+        size_t written = FAST_IMPL(_write_bfs_block)(sorted_keys, n_keys, d_n,
+                                                     out, sorted_rank_out,
+                                                     bfs_root, *out_pos,
+                                                     actual_depth,
+                                                     total_bfs_nodes);
+        *out_pos += written;
+
+        if (remaining_depth > block_depth) {
+            size_t children[1 << FAST_DK_MAX];
+            size_t nchildren = collect_children(bfs_root, actual_depth,
+                                                children, total_bfs_nodes);
+            for (size_t i = 0; i < nchildren; i++) {
+                if (FAST_IMPL(_lay_out_subtree)(sorted_keys, n_keys, d_n,
+                                                out, sorted_rank_out,
+                                                children[i], out_pos,
+                                                remaining_depth - actual_depth,
+                                                blocking_level,
+                                                depths, total_bfs_nodes,
+                                                scratch) != 0)
+                    return -1;
+            }
+        }
+    } else {
+        /* The top min(block_depth, remaining_depth) levels of this subtree
+         * form one block at the current granularity; lay them out with the
+         * next finer blocking level.  When the subtree is shallower than the
+         * block, the finer levels still apply (a 6-level subtree inside a
+         * page block is still cache-line and SIMD blocked). */
+        int top_depth = remaining_depth < block_depth ? remaining_depth : block_depth;
+
+        if (FAST_IMPL(_lay_out_subtree)(sorted_keys, n_keys, d_n,
+                                        out, sorted_rank_out,
+                                        bfs_root, out_pos,
+                                        top_depth, blocking_level - 1,
+                                        depths, total_bfs_nodes,
+                                        scratch) != 0)
+            return -1;
+
+        if (remaining_depth > top_depth) {
+            size_t max_children = (size_t)1 << top_depth;
+            size_t bytes = max_children * sizeof(size_t);
+            size_t mark = scratch ? scratch->hi : 0;
+            size_t *children = scratch
+                ? (size_t *)fast_arena_hi_alloc(scratch, bytes)
+                : (size_t *)malloc(bytes);
+            if (!children)
+                return -1;
+            size_t nchildren = collect_children(bfs_root, top_depth,
+                                                children, total_bfs_nodes);
+
+            int rc = 0;
+            for (size_t i = 0; i < nchildren && rc == 0; i++) {
+                rc = FAST_IMPL(_lay_out_subtree)(sorted_keys, n_keys, d_n,
+                                                 out, sorted_rank_out,
+                                                 children[i], out_pos,
+                                                 remaining_depth - top_depth,
+                                                 blocking_level,
+                                                 depths, total_bfs_nodes,
+                                                 scratch);
+            }
+            if (scratch)
+                scratch->hi = mark;
+            else
+                free(children);
+            if (rc != 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * One stripe of a parallel layout build: child subtrees of the top
+ * block, taken round-robin by thread id.  Every child subtree is the
+ * same size (the padded tree is complete), so its output start is pure
+ * arithmetic and the stripes write disjoint ranges.
+ */
+struct FAST_IMPL(_layout_task) {
+    const FAST_IMPL_KEY *sorted_keys;
+    size_t n;
+    int d_n;
+    FAST_IMPL_KEY *out;
+    int32_t *rank_out;
+    const int *depths;
+    size_t total_bfs_nodes;
+    const size_t *children;
+    size_t nchildren;
+    size_t first_out;     /* layout offset of child subtree 0 */
+    size_t child_size;    /* 2^rem - 1 */
+    int rem;              /* levels per child subtree */
+    int level;            /* blocking level for the children */
+    int nthreads, tid;
+    int started;
+    int rc;               /* -1 if any subtree in the stripe failed */
+};
+
+static void *FAST_IMPL(_layout_worker)(void *arg)
+{
+    struct FAST_IMPL(_layout_task) *task = (struct FAST_IMPL(_layout_task) *)arg;
+
+    task->rc = 0;
+    for (size_t i = (size_t)task->tid; i < task->nchildren;
+         i += (size_t)task->nthreads) {
+        size_t pos = task->first_out + i * task->child_size;
+        /* Workers never run on arena builds (those are serial), so the
+           scratch child lists come from the heap — and that malloc can
+           fail, leaving the stripe's output unwritten. */
+        if (FAST_IMPL(_lay_out_subtree)(task->sorted_keys, task->n,
+                                        task->d_n,
+                                        task->out, task->rank_out,
+                                        task->children[i], &pos,
+                                        task->rem, task->level,
+                                        task->depths, task->total_bfs_nodes,
+                                        NULL) != 0) {
+            task->rc = -1;
+            break;
+        }
+    }
+    return NULL;
+}
+
+int FAST_IMPL(_build_layout)(FAST_IMPL_TREE *t,
+                             const FAST_IMPL_KEY *sorted_keys, size_t n)
+{
+    /* Compute tree depth: d_N = ceil(log2(n+1)) so that 2^d_N - 1 >= n */
+    int d_n = 0;
+    {
+        size_t tmp = 1;
+        while (tmp - 1 < n) { d_n++; tmp <<= 1; }
+    }
+    size_t tree_nodes = ((size_t)1 << d_n) - 1;
+
+    t->d_n = d_n;
+    t->tree_nodes = tree_nodes;
+    t->n = n;
+
+    /* SIMD width is normally chosen by the create wrapper; default to
+       the narrowest constants for callers that build directly. */
+    if (t->d_k == 0) {
+        t->d_k = FAST_IMPL_DK;
+        t->n_k = (1 << FAST_IMPL_DK) - 1;
+        t->d_l = FAST_IMPL_DL;
+    }
+
+    /* Detect page size */
+    long ps = sysconf(_SC_PAGESIZE);
+    t->page_size = (ps > 0) ? (size_t)ps : 4096;
+    /* Compute d_p: largest d such that (2^d - 1) keys fit in a page.
+       A caller may preset it (the compressed mode blocks for 2-byte
+       deltas rather than for the stored key width). */
+    if (t->d_p == 0) {
+        int dp = 1;
+        while (((size_t)1 << (dp + 1)) - 1 <=
+               t->page_size / sizeof(FAST_IMPL_KEY)) {
+            dp++;
+        }
+        t->d_p = dp;
+    }
+    t->n_p = ((size_t)1 << t->d_p) - 1;
+
+    /* Superpage blocking only pays off when the tree spans multiple
+       2MB regions; otherwise leave the outermost level disabled. */
+    t->d_p2 = FAST_DP2_NONE;
+    if (t->want_huge && tree_nodes * sizeof(FAST_IMPL_KEY) > FAST_SUPERPAGE_BYTES) {
+        int dp2 = 1;
+        while (((size_t)1 << (dp2 + 1)) - 1 <=
+               FAST_SUPERPAGE_BYTES / sizeof(FAST_IMPL_KEY)) {
+            dp2++;
+        }
+        t->d_p2 = dp2;
+    }
+
+    /* Copy sorted keys.  The unsorted-ingest path has already sorted
+       the input into a pre-installed t->keys, in which case the copy
+       (a full extra pass over the array) is skipped. */
+    if (!t->keys) {
+        t->keys = t->arena
+            ? (FAST_IMPL_KEY *)fast_arena_lo_alloc(t->arena,
+                                                   n * sizeof(FAST_IMPL_KEY))
+            : (FAST_IMPL_KEY *)malloc(n * sizeof(FAST_IMPL_KEY));
+        if (!t->keys)
+            return -1;
+        memcpy(t->keys, sorted_keys, n * sizeof(FAST_IMPL_KEY));
+    }
+
+    /* Allocate output layout array (aligned to page boundary for TLB perf) */
+    size_t layout_bytes = tree_nodes * sizeof(FAST_IMPL_KEY);
+    /* Round up to multiple of 64 (cache line) and add padding so the
+       widest (512-bit) block load may read past the last node */
+    layout_bytes = ((layout_bytes + 63) / 64) * 64 + 64;
+    size_t layout_elems = layout_bytes / sizeof(FAST_IMPL_KEY);
+
+    if (FAST_IMPL(_alloc_layout)(t, layout_bytes) != 0) {
+        if (!t->arena)
+            free(t->keys);
+        t->keys = NULL;
+        return -1;
+    }
+
+    /* Allocate sorted_rank array (one rank per layout slot).  Compact
+       trees skip it entirely and recover the rank from the descent path. */
+    t->sorted_rank = NULL;
+    if (!t->compact) {
+        t->sorted_rank = t->arena
+            ? (int32_t *)fast_arena_lo_alloc(t->arena,
+                                             layout_elems * sizeof(int32_t))
+            : (int32_t *)malloc(layout_elems * sizeof(int32_t));
+        if (!t->sorted_rank) {
+            FAST_IMPL(_free_layout)(t);
+            if (!t->arena)
+                free(t->keys);
+            t->keys = NULL;
+            return -1;
+        }
+    }
+    t->layout_size = layout_elems;
+
+    /* Fill layout with sentinel, sorted_rank with n (invalid) */
+    for (size_t i = 0; i < layout_elems; i++) {
+        t->layout[i] = FAST_IMPL_KEY_MAX;
+        if (t->sorted_rank)
+            t->sorted_rank[i] = (int32_t)n;
+    }
+
+    /* Perform the full hierarchically blocked layout: the tree
+     * decomposes into page blocks of d_p levels, each page block into
+     * cache line blocks of d_L levels, and each cache line block into
+     * SIMD blocks of d_K levels.  Since the padded tree is complete,
+     * every subtree of depth d occupies exactly 2^d - 1 contiguous
+     * slots, so the search can compute nested child offsets with the
+     * same arithmetic at every level. */
+    int depths[4] = { t->d_k, t->d_l, t->d_p, t->d_p2 };
+
+    /* Pick the outermost blocking level whose top block is shallower
+       than the tree; its child subtrees are the parallel work units. */
+    int split_level = -1, top_depth = 0;
+    if (t->build_threads > 1 && !t->arena) {
+        /* Arena builds stay serial: the scratch bump pointer is not
+           thread-safe and the arena path targets many small trees. */
+        for (int lvl = 3; lvl >= 2; lvl--) {
+            int bd = (depths[lvl] < d_n) ? depths[lvl] : d_n;
+            if (bd < d_n) {
+                split_level = lvl;
+                top_depth = bd;
+                break;
+            }
+        }
+    }
+
+    if (split_level < 0) {
+        size_t out_pos = 0;
+        if (FAST_IMPL(_lay_out_subtree)(sorted_keys, n, d_n,
+                                        t->layout, t->sorted_rank,
+                                        0, &out_pos, d_n, 3, depths,
+                                        tree_nodes, t->arena) != 0) {
+            if (!t->arena)
+                free(t->sorted_rank);
+            t->sorted_rank = NULL;
+            FAST_IMPL(_free_layout)(t);
+            if (!t->arena)
+                free(t->keys);
+            t->keys = NULL;
+            return -1;
+        }
+        return 0;
+    }
+
+    /* Parallel build: lay out the top block serially (it is at most one
+       page block), then fan the 2^top_depth child subtrees out across
+       the thread pool.  Each child writes a disjoint output range whose
+       start follows from the uniform offset rule, so no synchronization
+       is needed beyond the final join. */
+    size_t out_pos = 0;
+    if (FAST_IMPL(_lay_out_subtree)(sorted_keys, n, d_n,
+                                    t->layout, t->sorted_rank,
+                                    0, &out_pos, top_depth, split_level - 1,
+                                    depths, tree_nodes, NULL) != 0) {
+        free(t->sorted_rank);
+        t->sorted_rank = NULL;
+        FAST_IMPL(_free_layout)(t);
+        free(t->keys);
+        t->keys = NULL;
+        return -1;
+    }
+
+    size_t max_children = (size_t)1 << top_depth;
+    size_t *children = (size_t *)malloc(max_children * sizeof(size_t));
+    if (!children) {
+        free(t->sorted_rank);
+        t->sorted_rank = NULL;
+        FAST_IMPL(_free_layout)(t);
+        free(t->keys);
+        t->keys = NULL;
+        return -1;
+    }
+    size_t nchildren = collect_children(0, top_depth, children, tree_nodes);
+
+    int nthreads = t->build_threads;
+    if ((size_t)nthreads > nchildren)
+        nthreads = (int)nchildren;
+
+    struct FAST_IMPL(_layout_task) *tasks = (struct FAST_IMPL(_layout_task) *)
+        malloc((size_t)nthreads * sizeof(struct FAST_IMPL(_layout_task)));
+    pthread_t *tids = (pthread_t *)malloc((size_t)nthreads * sizeof(pthread_t));
+    if (!tasks || !tids) {
+        free(tasks);
+        free(tids);
+        free(children);
+        free(t->sorted_rank);
+        t->sorted_rank = NULL;
+        FAST_IMPL(_free_layout)(t);
+        free(t->keys);
+        t->keys = NULL;
+        return -1;
+    }
+
+    for (int w = 0; w < nthreads; w++) {
+        tasks[w] = (struct FAST_IMPL(_layout_task)){
+            .sorted_keys = sorted_keys,
+            .n = n,
+            .d_n = d_n,
+            .out = t->layout,
+            .rank_out = t->sorted_rank,
+            .depths = depths,
+            .total_bfs_nodes = tree_nodes,
+            .children = children,
+            .nchildren = nchildren,
+            .first_out = (((size_t)1) << top_depth) - 1,
+            .child_size = (((size_t)1) << (d_n - top_depth)) - 1,
+            .rem = d_n - top_depth,
+            .level = split_level,
+            .nthreads = nthreads,
+            .tid = w,
+        };
+        if (w + 1 < nthreads) {
+            tasks[w].started = (pthread_create(&tids[w], NULL,
+                                               FAST_IMPL(_layout_worker),
+                                               &tasks[w]) == 0);
+            if (!tasks[w].started)
+                FAST_IMPL(_layout_worker)(&tasks[w]); /* degrade to inline */
+        }
+    }
+    /* The calling thread takes the last stripe itself */
+    FAST_IMPL(_layout_worker)(&tasks[nthreads - 1]);
+
+    int rc = 0;
+    for (int w = 0; w + 1 < nthreads; w++) {
+        if (tasks[w].started)
+            pthread_join(tids[w], NULL);
+    }
+    for (int w = 0; w < nthreads; w++) {
+        if (tasks[w].rc != 0)
+            rc = -1;
+    }
+
+    free(tids);
+    free(tasks);
+    free(children);
+
+    /* A failed stripe left part of the layout unwritten; surface the
+       failure instead of returning a tree with garbage in it. */
+    if (rc != 0) {
+        free(t->sorted_rank);
+        t->sorted_rank = NULL;
+        FAST_IMPL(_free_layout)(t);
+        free(t->keys);
+        t->keys = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+#undef FAST_IMPL
@@ -0,0 +1,292 @@
+#include "fast_internal.h"
+
+#include <sys/mman.h>
+
+/*
+ * 16-bit delta-compressed layout (fast_create_compressed).
+ *
+ * Key distributions are usually dense within a page-block subrange, so
+ * most blocks can store each key as an unsigned 16-bit offset from a
+ * per-block base instead of a raw int32, halving the layout footprint
+ * and doubling the keys resolved per cache line (d_L = 5, 31 deltas in
+ * 62 bytes; d_K = 3, 7 deltas per SSE compare).
+ *
+ * The delta array reuses the uncompressed layout's node indexing, so
+ * the nested child-offset arithmetic is unchanged; a small per-block
+ * directory carries the base key and, for the rare block whose deltas
+ * overflow 16 bits, an offset into a raw int32 arena searched with
+ * scalar compares.  The base of a block is the key at its reachable
+ * in-order lower bound (the descent's accumulated child index, `gci`,
+ * fixes the high bits of the final rank), so both the builder and the
+ * search derive the same block identity arithmetically: block id =
+ * round offset + gci.
+ *
+ * Padding nodes encode as FAST_DELTA_SENTINEL, and the query delta is
+ * clamped to it, so a clamped query never compares greater than a
+ * sentinel; real keys must fit in FAST_DELTA_MAX.  Compressed trees
+ * are always compact — ranks come from the descent path.
+ */
+
+struct comp_state {
+    struct fast_tree *t;
+    const int32_t *layout;   /* uncompressed layout being transcoded */
+    size_t raw_used;
+    size_t raw_cap;
+    int failed;
+};
+
+static int comp_reserve_raw(struct comp_state *st, size_t need)
+{
+    if (st->raw_used + need <= st->raw_cap)
+        return 0;
+
+    size_t cap = st->raw_cap ? st->raw_cap * 2 : 4096;
+    while (cap < st->raw_used + need)
+        cap *= 2;
+
+    int32_t *p = (int32_t *)realloc(st->t->comp_raw, cap * sizeof(int32_t));
+    if (!p)
+        return -1;
+    st->t->comp_raw = p;
+    st->raw_cap = cap;
+    return 0;
+}
+
+/*
+ * Transcode one page block and recurse into its children.  `gci` is
+ * the accumulated child index (d_n - rem bits), `pos` the block's
+ * layout offset, `rem` the levels remaining including this block.
+ */
+static void comp_transcode(struct comp_state *st, size_t gci, int round,
+                           int rem, size_t pos)
+{
+    struct fast_tree *t = st->t;
+    int t_p = (rem < t->d_p) ? rem : t->d_p;
+    size_t bsize = (((size_t)1) << t_p) - 1;
+    size_t lo_rank = gci << rem;
+    int32_t base = (lo_rank < t->n) ? t->keys[lo_rank] : FAST_KEY_MAX;
+
+    if (st->failed)
+        return;
+
+    int fits = 1;
+    for (size_t i = 0; i < bsize; i++) {
+        int32_t k = st->layout[pos + i];
+        if (k == FAST_KEY_MAX)
+            continue;  /* padding node */
+        int64_t d = (int64_t)k - base;
+        if (d < 0 || d > (int64_t)FAST_DELTA_MAX) {
+            fits = 0;
+            break;
+        }
+    }
+
+    struct fast_comp_dir *e = &t->comp_dir[t->comp_round_off[round] + gci];
+    e->base = base;
+    if (fits) {
+        e->raw_off = -1;
+        for (size_t i = 0; i < bsize; i++) {
+            int32_t k = st->layout[pos + i];
+            t->comp_deltas[pos + i] = (k == FAST_KEY_MAX)
+                ? (uint16_t)FAST_DELTA_SENTINEL
+                : (uint16_t)(k - base);
+        }
+    } else {
+        if (comp_reserve_raw(st, bsize) != 0) {
+            st->failed = 1;
+            return;
+        }
+        e->raw_off = (int32_t)st->raw_used;
+        memcpy(t->comp_raw + st->raw_used, st->layout + pos,
+               bsize * sizeof(int32_t));
+        st->raw_used += bsize;
+    }
+
+    if (rem > t_p) {
+        size_t child_size = (((size_t)1) << (rem - t_p)) - 1;
+        for (size_t c = 0; c < (((size_t)1) << t_p); c++)
+            comp_transcode(st, (gci << t_p) | c, round + 1, rem - t_p,
+                           pos + bsize + c * child_size);
+    }
+}
+
+/*
+ * Replace the freshly built int32 layout with its compressed form.
+ * On success the layout is released and searches go through
+ * fast_search_comp; on failure the tree is left for the caller to
+ * destroy.
+ */
+int fast_compress_layout(struct fast_tree *t)
+{
+    /* Count page blocks per round; block ids are round-major. */
+    size_t nblocks = 0;
+    {
+        int rem = t->d_n, r = 0;
+        size_t width_bits = 0;
+        while (rem > 0) {
+            t->comp_round_off[r++] = nblocks;
+            nblocks += ((size_t)1) << width_bits;
+            int t_p = (rem < t->d_p) ? rem : t->d_p;
+            width_bits += (size_t)t_p;
+            rem -= t_p;
+        }
+    }
+
+    t->comp_deltas = (uint16_t *)malloc(t->layout_size * sizeof(uint16_t));
+    t->comp_dir = (struct fast_comp_dir *)
+        malloc(nblocks * sizeof(struct fast_comp_dir));
+    if (!t->comp_deltas || !t->comp_dir)
+        return -1;
+    memset(t->comp_deltas, 0xFF, t->layout_size * sizeof(uint16_t));
+
+    struct comp_state st = { .t = t, .layout = t->layout };
+    comp_transcode(&st, 0, 0, t->d_n, 0);
+    if (st.failed)
+        return -1;
+    t->comp_raw_size = st.raw_used;
+
+    /* The int32 layout is no longer needed */
+    if (t->layout_map)
+        munmap(t->layout_map, t->layout_map_bytes);
+    else
+        free(t->layout);
+    t->layout = NULL;
+    t->layout_map = NULL;
+    t->layout_map_bytes = 0;
+    return 0;
+}
+
+#if FAST_HAVE_SSE
+/*
+ * Greater-than mask over one 7-delta SIMD block.  _mm_cmpgt_epi16 is a
+ * signed compare, so both sides are biased by 0x8000; the pack folds
+ * the 16-bit lane masks down to one movemask bit per lane.
+ */
+static inline unsigned comp_block_mask(const uint16_t *blk, uint16_t qd)
+{
+    __m128i bias = _mm_set1_epi16((short)0x8000);
+    __m128i v_q = _mm_xor_si128(_mm_set1_epi16((short)qd), bias);
+    __m128i v_t = _mm_xor_si128(_mm_loadu_si128((const __m128i *)blk), bias);
+    __m128i cmp = _mm_cmpgt_epi16(v_q, v_t);
+    return (unsigned)_mm_movemask_epi8(_mm_packs_epi16(cmp, _mm_setzero_si128()));
+}
+#endif
+
+/*
+ * Descend the cache line / SIMD levels of one delta-encoded page block
+ * of t_p levels; returns the block-local child index (t_p bits).  Same
+ * nested offset arithmetic as FAST_DESCEND, over 2-byte elements.
+ */
+static size_t comp_block_walk(const struct fast_tree *t, const uint16_t *blk,
+                              uint16_t qd, int t_p)
+{
+    size_t base_l = 0, c_b = 0;
+    int rem_l = t_p;
+
+    while (rem_l > 0) {
+        int t_l = (rem_l < t->d_l) ? rem_l : t->d_l;
+        int rem_k = t_l;
+        size_t c_l = 0, base_k = base_l;
+
+        while (rem_k > 0) {
+            int b = (rem_k <= t->d_k + 1) ? rem_k : t->d_k;
+            int child;
+#if FAST_HAVE_SSE
+            unsigned mask = comp_block_mask(blk + base_k, qd);
+            if (b > t->d_k) {
+                /* Folded 15-delta terminal block: second overlapping
+                   load covers the bottom row. */
+                mask |= comp_block_mask(blk + base_k + t->n_k, qd)
+                        << t->n_k;
+            }
+            child = fast_mask_to_child(mask, b);
+#else
+            unsigned node = 0;
+            for (int i = 0; i < b; i++)
+                node = 2 * node + 1 + (qd > blk[base_k + node] ? 1u : 0u);
+            child = (int)(node - (((unsigned)1 << b) - 1));
+#endif
+            rem_k -= b;
+            c_l = (c_l << b) | (size_t)child;
+            if (rem_k > 0)
+                base_k += ((((size_t)1) << b) - 1) +
+                          (size_t)child * ((((size_t)1) << rem_k) - 1);
+        }
+
+        rem_l -= t_l;
+        c_b = (c_b << t_l) | c_l;
+        if (rem_l > 0)
+            base_l += ((((size_t)1) << t_l) - 1) +
+                      c_l * ((((size_t)1) << rem_l) - 1);
+    }
+    return c_b;
+}
+
+/* Raw int32 fallback block: same walk, scalar compares on full keys. */
+static size_t raw_block_walk(const struct fast_tree *t, const int32_t *blk,
+                             int32_t key, int t_p)
+{
+    size_t base_l = 0, c_b = 0;
+    int rem_l = t_p;
+
+    while (rem_l > 0) {
+        int t_l = (rem_l < t->d_l) ? rem_l : t->d_l;
+        int rem_k = t_l;
+        size_t c_l = 0, base_k = base_l;
+
+        while (rem_k > 0) {
+            int b = (rem_k <= t->d_k + 1) ? rem_k : t->d_k;
+            unsigned node = 0;
+            for (int i = 0; i < b; i++)
+                node = 2 * node + 1 + (key > blk[base_k + node] ? 1u : 0u);
+            int child = (int)(node - (((unsigned)1 << b) - 1));
+            rem_k -= b;
+            c_l = (c_l << b) | (size_t)child;
+            if (rem_k > 0)
+                base_k += ((((size_t)1) << b) - 1) +
+                          (size_t)child * ((((size_t)1) << rem_k) - 1);
+        }
+
+        rem_l -= t_l;
+        c_b = (c_b << t_l) | c_l;
+        if (rem_l > 0)
+            base_l += ((((size_t)1) << t_l) - 1) +
+                      c_l * ((((size_t)1) << rem_l) - 1);
+    }
+    return c_b;
+}
+
+void fast_search_comp(const struct fast_tree *t, int32_t key, int64_t *result)
+{
+    FAST_SEARCH_BOUNDS(t, key, result);
+
+    size_t gci = 0, base_p = 0;
+    int rem = t->d_n, round = 0;
+
+    while (rem > 0) {
+        int t_p = (rem < t->d_p) ? rem : t->d_p;
+        const struct fast_comp_dir *e =
+            &t->comp_dir[t->comp_round_off[round] + gci];
+        size_t c_p;
+
+        if (e->raw_off >= 0) {
+            c_p = raw_block_walk(t, t->comp_raw + e->raw_off, key, t_p);
+        } else {
+            int64_t qd64 = (int64_t)key - e->base;
+            uint16_t qd = (qd64 < 0) ? 0
+                        : (qd64 > (int64_t)FAST_DELTA_SENTINEL)
+                            ? (uint16_t)FAST_DELTA_SENTINEL
+                            : (uint16_t)qd64;
+            c_p = comp_block_walk(t, t->comp_deltas + base_p, qd, t_p);
+        }
+
+        rem -= t_p;
+        gci = (gci << t_p) | c_p;
+        if (rem > 0)
+            base_p += ((((size_t)1) << t_p) - 1) +
+                      c_p * ((((size_t)1) << rem) - 1);
+        round++;
+    }
+
+    *result = resolve_path(t, key, gci);
+}
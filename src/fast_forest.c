@@ -0,0 +1,179 @@
+/*
+ * Sharded forest: many FAST trees behind one search entry point.
+ *
+ * Keyspaces that reindex under a rebuild-time budget shard into many
+ * trees, which leaves each query an extra routing step — typically a
+ * branchy binary search over a boundary array, paid before the real
+ * descent even starts.  The forest makes routing a FAST search too: the
+ * shard boundaries are built into their own (tiny, cache-resident)
+ * tree, so the router is the same branch-free SIMD mask-and-lookup as
+ * the shards, and a query goes boundary descent -> shard descent in one
+ * call.
+ *
+ * Results are global ranks over the concatenated sorted keyspace: each
+ * shard's local result is rebased by the number of keys in the shards
+ * before it.  A predecessor miss inside shard s (key below the shard's
+ * first key) lands on offset[s] - 1, the last key of the previous
+ * shard, so the forest behaves exactly like one big tree would.
+ *
+ * The batch entry point routes the whole query array through the
+ * router's pipelined batch search, groups the queries per shard, and
+ * runs one batch per shard — so each shard's upper levels are touched
+ * once per batch instead of once per query.
+ */
+
+#include "fast_internal.h"
+
+struct fast_forest {
+    fast_tree_t **trees;     /* owned, in boundary order */
+    fast_tree_t *router;     /* FAST tree over the boundary keys */
+    int64_t *offset;         /* offset[i] = keys in shards [0, i); count+1 */
+    size_t count;
+};
+
+fast_forest_t *fast_forest_create(fast_tree_t *const *trees,
+                                  const int32_t *boundaries, size_t count)
+{
+    if (!trees || !boundaries || count == 0)
+        return NULL;
+    for (size_t i = 0; i < count; i++) {
+        if (!trees[i])
+            return NULL;
+        if (i > 0 && boundaries[i - 1] >= boundaries[i])
+            return NULL;     /* boundaries must be strictly increasing */
+    }
+
+    struct fast_forest *f =
+        (struct fast_forest *)calloc(1, sizeof(struct fast_forest));
+    if (!f)
+        return NULL;
+
+    f->count = count;
+    f->trees = (fast_tree_t **)malloc(count * sizeof(fast_tree_t *));
+    f->offset = (int64_t *)malloc((count + 1) * sizeof(int64_t));
+    if (!f->trees || !f->offset)
+        goto fail;
+    memcpy(f->trees, trees, count * sizeof(fast_tree_t *));
+
+    /* Shard sizes are captured here: the shards are owned by the
+       forest from now on and must not grow behind its back. */
+    f->offset[0] = 0;
+    for (size_t i = 0; i < count; i++)
+        f->offset[i + 1] = f->offset[i] + (int64_t)fast_size(trees[i]);
+
+    f->router = fast_create(boundaries, count);
+    if (!f->router)
+        goto fail;
+    return f;
+
+fail:
+    free(f->trees);
+    free(f->offset);
+    free(f);
+    return NULL;
+}
+
+/* Boundary descent: index of the owning shard.  Queries below every
+   boundary clamp to shard 0, whose search then misses naturally. */
+static inline size_t forest_route(const struct fast_forest *f, int32_t key)
+{
+    int64_t s = fast_search(f->router, key);
+    return (s < 0) ? 0 : (size_t)s;
+}
+
+int64_t fast_forest_search(const fast_forest_t *forest, int32_t key)
+{
+    if (!forest)
+        return -1;
+    size_t s = forest_route(forest, key);
+    /* A local miss (-1) rebases to the last key of the prior shards. */
+    return forest->offset[s] + fast_search(forest->trees[s], key);
+}
+
+int64_t fast_forest_lower_bound(const fast_forest_t *forest, int32_t key)
+{
+    if (!forest)
+        return 0;
+    size_t s = forest_route(forest, key);
+    return forest->offset[s] +
+           fast_search_lower_bound(forest->trees[s], key);
+}
+
+void fast_forest_search_batch(const fast_forest_t *forest,
+                              const int32_t *queries, size_t m,
+                              int64_t *results)
+{
+    if (!forest || !queries || !results || m == 0)
+        return;
+
+    /* Scratch: routed shard per query (reused for the grouped
+       results), the grouped query array, and the inverse permutation.
+       On allocation failure degrade to the per-query path. */
+    int64_t *shard = (int64_t *)malloc(m * sizeof(int64_t));
+    int32_t *grouped = (int32_t *)malloc(m * sizeof(int32_t));
+    size_t *origin = (size_t *)malloc(m * sizeof(size_t));
+    size_t *fill = (size_t *)calloc(forest->count + 1, sizeof(size_t));
+    if (!shard || !grouped || !origin || !fill) {
+        free(shard);
+        free(grouped);
+        free(origin);
+        free(fill);
+        for (size_t i = 0; i < m; i++)
+            results[i] = fast_forest_search(forest, queries[i]);
+        return;
+    }
+
+    /* Route the whole batch through the boundary tree's pipeline. */
+    fast_search_batch(forest->router, queries, m, shard);
+    for (size_t i = 0; i < m; i++) {
+        if (shard[i] < 0)
+            shard[i] = 0;
+        fill[shard[i] + 1]++;
+    }
+    for (size_t s = 0; s < forest->count; s++)
+        fill[s + 1] += fill[s];
+
+    /* Counting-sort the queries into per-shard runs (stable, so equal
+       keys keep their arrival order within a shard). */
+    for (size_t i = 0; i < m; i++) {
+        size_t slot = fill[shard[i]]++;
+        grouped[slot] = queries[i];
+        origin[slot] = i;
+    }
+    /* fill[s] now marks the end of shard s's run; recover the starts. */
+    for (size_t s = forest->count; s > 0; s--)
+        fill[s] = fill[s - 1];
+    fill[0] = 0;
+
+    for (size_t s = 0; s < forest->count; s++) {
+        size_t lo = fill[s], hi = fill[s + 1];
+        if (lo == hi)
+            continue;
+        fast_search_batch(forest->trees[s], grouped + lo, hi - lo,
+                          shard + lo);
+        for (size_t j = lo; j < hi; j++)
+            results[origin[j]] = forest->offset[s] + shard[j];
+    }
+
+    free(fill);
+    free(origin);
+    free(grouped);
+    free(shard);
+}
+
+size_t fast_forest_size(const fast_forest_t *forest)
+{
+    return forest ? (size_t)forest->offset[forest->count] : 0;
+}
+
+void fast_forest_destroy(fast_forest_t *forest)
+{
+    if (!forest)
+        return;
+    for (size_t i = 0; i < forest->count; i++)
+        fast_destroy(forest->trees[i]);
+    fast_destroy(forest->router);
+    free(forest->trees);
+    free(forest->offset);
+    free(forest);
+}
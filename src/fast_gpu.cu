@@ -0,0 +1,263 @@
+/*
+ * CUDA bulk-probe engine: the GPU half of the SIGMOD 2010 design.
+ *
+ * The blocked layout and key array are uploaded once per tree (lazily,
+ * on the first fast_search_batch_gpu call) and cached on the device, so
+ * a static tree serving many join probes pays the PCIe cost once.  Each
+ * query is traversed by one thread: with 4-byte keys and a scalar
+ * in-block walk a thread touches one 128-byte sector per cache line
+ * block, and tens of thousands of resident threads cover the latency —
+ * profiling in the paper (Section 6.2) shows this saturates GPU memory
+ * throughput where a warp-per-query ballot scheme leaves lanes idle.
+ * The SIMD blocking depth is irrelevant on the device; the cache line
+ * and page blocking of the uploaded layout still provide the locality.
+ *
+ * Queries stream through fixed-size device chunk buffers so arbitrarily
+ * large probe arrays run in bounded device memory.  The caller's query
+ * and result arrays are page-locked for the duration of a call (async
+ * copies are only asynchronous against pinned host memory), letting
+ * copy-up, kernel and copy-back overlap across two streams; if
+ * registration fails the copies degrade to synchronous pageable
+ * transfers, which are slower but still correct.
+ *
+ * Compressed trees keep no int32 layout and are not offloaded; trees
+ * with unmerged inserts would need the delta buffer consulted per probe
+ * and are likewise left to the CPU tier (merge first).
+ */
+
+#include "fast_internal.h"
+
+#include <cuda_runtime.h>
+#include <pthread.h>
+
+#define FAST_GPU_CHUNK   (1u << 22)  /* queries per staged chunk */
+#define FAST_GPU_TPB     256         /* threads per block */
+
+struct fast_gpu {
+    int32_t *layout;     /* device copy of the blocked layout */
+    int32_t *keys;       /* device copy of the sorted keys */
+    int32_t *queries[2]; /* per-stream device query chunks */
+    int64_t *results[2]; /* per-stream device result chunks */
+    cudaStream_t stream[2];
+};
+
+/*
+ * One thread per query: the same four nested blocking loops as
+ * FAST_DESCEND in fast_search.c, with the block compare done as the
+ * scalar node walk and the rank recovered from the accumulated path
+ * (resolve_path), which works for rank-table and compact trees alike.
+ */
+static __global__ void fast_gpu_search_kernel(
+    const int32_t *__restrict__ layout, const int32_t *__restrict__ keys,
+    size_t n, int d_n, int d_p2, int d_p, int d_l, int d_k,
+    const int32_t *__restrict__ queries, size_t m,
+    int64_t *__restrict__ results)
+{
+    size_t qi = (size_t)blockIdx.x * blockDim.x + threadIdx.x;
+    if (qi >= m)
+        return;
+
+    int32_t key = queries[qi];
+
+    if (key < keys[0]) {
+        results[qi] = -1;
+        return;
+    }
+    if (key >= keys[n - 1]) {
+        results[qi] = (int64_t)(n - 1);
+        return;
+    }
+
+    size_t base_s = 0, base_p, base_l, base_k;
+    size_t c_s, c_p, c_l, path = 0;
+    int rem_s = d_n;
+
+    while (rem_s > 0) {
+        int t_s = (rem_s < d_p2) ? rem_s : d_p2;
+        int rem_p = t_s;
+        c_s = 0;
+        base_p = base_s;
+        while (rem_p > 0) {
+            int t_p = (rem_p < d_p) ? rem_p : d_p;
+            int rem_l = t_p;
+            c_p = 0;
+            base_l = base_p;
+            while (rem_l > 0) {
+                int t_l = (rem_l < d_l) ? rem_l : d_l;
+                int rem_k = t_l;
+                c_l = 0;
+                base_k = base_l;
+                while (rem_k > 0) {
+                    int b = (rem_k <= d_k + 1) ? rem_k : d_k;
+                    unsigned node = 0;
+                    for (int i = 0; i < b; i++)
+                        node = 2 * node + 1 +
+                               (key > __ldg(layout + base_k + node));
+                    int child_index = (int)(node - ((1u << b) - 1));
+                    rem_k -= b;
+                    c_l = (c_l << b) | (size_t)child_index;
+                    if (rem_k > 0)
+                        base_k += ((((size_t)1) << b) - 1) +
+                            (size_t)child_index * ((((size_t)1) << rem_k) - 1);
+                }
+                rem_l -= t_l;
+                c_p = (c_p << t_l) | c_l;
+                if (rem_l > 0)
+                    base_l += ((((size_t)1) << t_l) - 1) +
+                              c_l * ((((size_t)1) << rem_l) - 1);
+            }
+            rem_p -= t_p;
+            c_s = (c_s << t_p) | c_p;
+            if (rem_p > 0)
+                base_p += ((((size_t)1) << t_p) - 1) +
+                          c_p * ((((size_t)1) << rem_p) - 1);
+        }
+        path = (path << t_s) | c_s;
+        rem_s -= t_s;
+        if (rem_s > 0)
+            base_s += ((((size_t)1) << t_s) - 1) +
+                      c_s * ((((size_t)1) << rem_s) - 1);
+    }
+
+    int64_t lo = (int64_t)path - 1;
+    if (lo >= (int64_t)n) lo = (int64_t)n - 1;
+    for (int i = 0; i < 3 && lo + 1 < (int64_t)n; i++) {
+        if (__ldg(keys + lo + 1) <= key)
+            lo++;
+        else
+            break;
+    }
+    results[qi] = lo;
+}
+
+static void fast_gpu_free_state(struct fast_gpu *g)
+{
+    for (int s = 0; s < 2; s++) {
+        if (g->stream[s])
+            cudaStreamDestroy(g->stream[s]);
+        cudaFree(g->queries[s]);
+        cudaFree(g->results[s]);
+    }
+    cudaFree(g->layout);
+    cudaFree(g->keys);
+    free(g);
+}
+
+/* Upload the tree once; serialized so concurrent first probes race safely. */
+static pthread_mutex_t fast_gpu_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct fast_gpu *fast_gpu_upload(struct fast_tree *t)
+{
+    pthread_mutex_lock(&fast_gpu_lock);
+    if (t->gpu) {
+        pthread_mutex_unlock(&fast_gpu_lock);
+        return (struct fast_gpu *)t->gpu;
+    }
+
+    struct fast_gpu *g = (struct fast_gpu *)calloc(1, sizeof(*g));
+    if (!g) {
+        pthread_mutex_unlock(&fast_gpu_lock);
+        return NULL;
+    }
+
+    int ok =
+        cudaMalloc(&g->layout, t->layout_size * sizeof(int32_t)) == cudaSuccess &&
+        cudaMalloc(&g->keys, t->n * sizeof(int32_t)) == cudaSuccess &&
+        cudaMemcpy(g->layout, t->layout, t->layout_size * sizeof(int32_t),
+                   cudaMemcpyHostToDevice) == cudaSuccess &&
+        cudaMemcpy(g->keys, t->keys, t->n * sizeof(int32_t),
+                   cudaMemcpyHostToDevice) == cudaSuccess;
+    for (int s = 0; ok && s < 2; s++) {
+        ok = cudaMalloc(&g->queries[s], FAST_GPU_CHUNK * sizeof(int32_t)) == cudaSuccess &&
+             cudaMalloc(&g->results[s], FAST_GPU_CHUNK * sizeof(int64_t)) == cudaSuccess &&
+             cudaStreamCreate(&g->stream[s]) == cudaSuccess;
+    }
+    if (!ok) {
+        fast_gpu_free_state(g);
+        pthread_mutex_unlock(&fast_gpu_lock);
+        return NULL;
+    }
+
+    t->gpu = g;
+    pthread_mutex_unlock(&fast_gpu_lock);
+    return g;
+}
+
+extern "C" int fast_gpu_available(void)
+{
+    int n = 0;
+    return cudaGetDeviceCount(&n) == cudaSuccess && n > 0;
+}
+
+extern "C" int fast_search_batch_gpu(const fast_tree_t *tree,
+                                     const int32_t *queries, size_t m,
+                                     int64_t *results)
+{
+    if (!tree || !queries || !results)
+        return -1;
+    if (tree->n == 0 || tree->compressed || tree->delta_n)
+        return -1;
+    if (!fast_gpu_available())
+        return -1;
+    if (m == 0)
+        return 0;
+
+    struct fast_gpu *g = fast_gpu_upload((struct fast_tree *)tree);
+    if (!g)
+        return -1;
+
+    /* Depth 0: one key, no layout to probe. */
+    if (tree->d_n == 0) {
+        for (size_t i = 0; i < m; i++)
+            results[i] = (queries[i] >= tree->keys[0]) ? 0 : -1;
+        return 0;
+    }
+
+    /* Page-lock the caller's arrays so the per-chunk async copies are
+       actually asynchronous; best effort (see the file header). */
+    int q_pinned = cudaHostRegister((void *)queries, m * sizeof(int32_t),
+                                    cudaHostRegisterDefault) == cudaSuccess;
+    int r_pinned = cudaHostRegister(results, m * sizeof(int64_t),
+                                    cudaHostRegisterDefault) == cudaSuccess;
+
+    /* Round-robin chunks across the two streams; the copy-up of one
+       chunk overlaps the kernel and copy-back of the previous one. */
+    int rc = 0;
+    int s = 0;
+    for (size_t off = 0; off < m && rc == 0; off += FAST_GPU_CHUNK, s ^= 1) {
+        size_t c = m - off;
+        if (c > FAST_GPU_CHUNK)
+            c = FAST_GPU_CHUNK;
+
+        unsigned blocks = (unsigned)((c + FAST_GPU_TPB - 1) / FAST_GPU_TPB);
+        if (cudaMemcpyAsync(g->queries[s], queries + off,
+                            c * sizeof(int32_t), cudaMemcpyHostToDevice,
+                            g->stream[s]) != cudaSuccess)
+            rc = -1;
+        fast_gpu_search_kernel<<<blocks, FAST_GPU_TPB, 0, g->stream[s]>>>(
+            g->layout, g->keys, tree->n, tree->d_n, tree->d_p2, tree->d_p,
+            tree->d_l, tree->d_k, g->queries[s], c, g->results[s]);
+        if (cudaMemcpyAsync(results + off, g->results[s],
+                            c * sizeof(int64_t), cudaMemcpyDeviceToHost,
+                            g->stream[s]) != cudaSuccess)
+            rc = -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (cudaStreamSynchronize(g->stream[i]) != cudaSuccess)
+            rc = -1;
+    }
+
+    if (q_pinned)
+        cudaHostUnregister((void *)queries);
+    if (r_pinned)
+        cudaHostUnregister(results);
+    return rc;
+}
+
+extern "C" void fast_gpu_release(struct fast_tree *t)
+{
+    if (!t || !t->gpu)
+        return;
+    fast_gpu_free_state((struct fast_gpu *)t->gpu);
+    t->gpu = NULL;
+}
@@ -0,0 +1,28 @@
+/*
+ * Stubs for builds without the CUDA engine (the default).  The real
+ * implementation lives in fast_gpu.cu, selected by -DFAST_ENABLE_CUDA;
+ * here the entry points report the engine as unavailable so callers
+ * fall back to the CPU batch path.
+ */
+
+#include "fast_internal.h"
+
+int fast_gpu_available(void)
+{
+    return 0;
+}
+
+int fast_search_batch_gpu(const fast_tree_t *tree, const int32_t *queries,
+                          size_t m, int64_t *results)
+{
+    (void)tree;
+    (void)queries;
+    (void)m;
+    (void)results;
+    return -1;
+}
+
+void fast_gpu_release(struct fast_tree *t)
+{
+    (void)t;
+}
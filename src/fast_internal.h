@@ -14,6 +14,39 @@
 #define FAST_HAVE_SSE 0
 #endif
 
+/*
+ * Wider kernels (AVX2, AVX-512) are compiled with per-function target
+ * attributes and selected at fast_create time via CPUID, so one binary
+ * serves the whole range of x86-64 machines.
+ */
+#if FAST_HAVE_SSE && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define FAST_HAVE_AVX_DISPATCH 1
+#else
+#define FAST_HAVE_AVX_DISPATCH 0
+#endif
+
+/*
+ * AArch64: NEON is architecturally guaranteed, so the 128-bit kernel
+ * (same d_K = 2 blocking as SSE, movemask emulated with a bit-weight
+ * multiply) is always available.  With SVE the vector length is only
+ * known at runtime: svcntw() sizes d_K at fast_create time, giving
+ * AVX2-like blocking on 256-bit parts and AVX-512-like on 512-bit.
+ */
+#if !FAST_HAVE_SSE && defined(__aarch64__)
+#include <arm_neon.h>
+#define FAST_HAVE_NEON 1
+#else
+#define FAST_HAVE_NEON 0
+#endif
+
+#if FAST_HAVE_NEON && defined(__ARM_FEATURE_SVE)
+#include <arm_sve.h>
+#define FAST_HAVE_SVE 1
+#else
+#define FAST_HAVE_SVE 0
+#endif
+
 /*
  * Architecture constants for 32-bit keys on x86-64.
  *
@@ -37,6 +70,20 @@
 #define FAST_NK     3    /* 2^FAST_DK - 1 */
 #define FAST_NK1    4    /* FAST_NK + 1: number of child subtrees per SIMD block */
 
+/*
+ * Wider SIMD registers resolve more levels per compare:
+ *   AVX2    (256-bit): d_K = 3, 7 keys per block (28 bytes + padding lane)
+ *   AVX-512 (512-bit): d_K = 4, 15 keys per block (60 bytes + padding lane)
+ * The cache line block depth follows the SIMD depth: with d_K = 4 one
+ * SIMD block *is* a full cache line, and with d_K = 3 a d_L of 3 keeps
+ * SIMD blocks from straddling cache line block boundaries.
+ */
+#define FAST_DK_AVX2    3
+#define FAST_NK_AVX2    7
+#define FAST_DK_AVX512  4
+#define FAST_NK_AVX512 15
+#define FAST_DK_MAX     4
+
 #define FAST_DL     4
 #define FAST_NL    15    /* 2^FAST_DL - 1 */
 #define FAST_NL1   16    /* FAST_NL + 1 */
@@ -44,12 +91,56 @@
 #define FAST_DP_4K 10
 #define FAST_NP_4K 1023  /* 2^10 - 1 */
 
+/*
+ * Blocking constants for 16-bit delta-compressed layouts: 2-byte
+ * elements double the fan-out per granule (7 deltas per 128-bit SSE
+ * block, 31 per cache line block, 2047 per 4KB page block).
+ */
+#define FAST_DK16  3
+#define FAST_DL16  5
+#define FAST_DP16 11
+
+/*
+ * Delta encoding: real keys must encode as base + delta with
+ * delta <= FAST_DELTA_MAX or the block falls back to raw int32;
+ * FAST_DELTA_SENTINEL is reserved for padding nodes so the clamped
+ * query delta (65535) never compares greater than them.
+ */
+#define FAST_DELTA_MAX      65534u
+#define FAST_DELTA_SENTINEL 65535u
+
 #define FAST_DP_2M 19
 #define FAST_NP_2M 524287 /* 2^19 - 1 */
 
+/*
+ * Superpage blocking depth meaning "disabled": the min() against the
+ * remaining depth makes the whole tree one superpage block, so the
+ * outermost descent loop runs exactly once and costs nothing.
+ */
+#define FAST_DP2_NONE 63
+
+#define FAST_SUPERPAGE_BYTES (2u * 1024 * 1024)
+
+/* Upper bound on NUMA nodes tracked for replica routing. */
+#define FAST_NUMA_MAX_NODES 64
+
 /* Sentinel value used to pad incomplete trees. */
 #define FAST_KEY_MAX INT32_MAX
 
+/*
+ * Blocking constants for the int64_t key variant.  8-byte keys halve
+ * the fan-out at every granularity: one key per 128-bit SSE block
+ * (d_K = 1, where the "SIMD" compare degenerates to a scalar one),
+ * 3 keys per AVX2 block, 7 per AVX-512 block, and 7 keys (56 bytes)
+ * per cache line block.
+ */
+#define FAST64_DK         1
+#define FAST64_DK_AVX2    2
+#define FAST64_DK_AVX512  3
+#define FAST64_DL         3
+
+#define FAST_KEY64_MAX INT64_MAX
+
 /*
  * Lookup table for SSE mask → child index.
  *
@@ -89,6 +180,65 @@ static const int FAST_LOOKUP[16] = {
     0, -1, 1, 2, -1, -1, -1, 3    /* indices 8-15 (bit 3 = don't care) */
 };
 
+/*
+ * Optional hot-path counters (configure with -DFAST_STATS=ON).
+ *
+ * Each tree owns FAST_STATS_SLOTS cache-line-sized counter slots; a
+ * thread picks its slot once by thread-local id, so the relaxed atomic
+ * increments land on a line no other thread is writing and cost little
+ * more than a plain add.  fast_stats_get() sums the slots on read.
+ * Without the option the macro expands to nothing and the search paths
+ * compile byte-identical to an uninstrumented build.
+ */
+#ifdef FAST_STATS
+#include <stdatomic.h>
+
+#define FAST_STATS_SLOTS 16
+
+enum {
+    FAST_ST_SEARCHES,      /* descents started */
+    FAST_ST_LEVELS,        /* tree levels those descents traversed */
+    FAST_ST_LEAF_SCANS,    /* forward fixup steps in leaf resolution */
+    FAST_ST_BOUNDS_EXITS,  /* queries answered by the boundary checks */
+    FAST_ST_BATCH_ROUNDS,  /* batch pipeline passes over the cursor slots */
+    FAST_ST_BATCH_STEPS,   /* cursor steps taken by those passes */
+    FAST_ST_COUNT
+};
+
+struct fast_stats_slot {
+    _Atomic uint64_t c[FAST_ST_COUNT];
+} __attribute__((aligned(64)));
+
+unsigned fast_stats_slot_id(void);
+
+#define FAST_STAT_ADD(t, idx, v)                                            \
+    do {                                                                    \
+        if ((t)->stats)                                                     \
+            atomic_fetch_add_explicit(                                      \
+                &((struct fast_stats_slot *)(t)->stats)                     \
+                     [fast_stats_slot_id()].c[(idx)],                       \
+                (uint64_t)(v), memory_order_relaxed);                       \
+    } while (0)
+#else
+#define FAST_STAT_ADD(t, idx, v) ((void)0)
+#endif
+
+/* Attach counter slots to a freshly built tree; no-op without
+   FAST_STATS (and on allocation failure the tree just stays
+   uninstrumented). */
+void fast_stats_attach(struct fast_tree *t);
+
+/*
+ * Per-page-block directory entry for the compressed layout.  `base` is
+ * the key at the block's reachable in-order lower bound; `raw_off` is
+ * the block's offset into the raw int32 arena when its deltas overflow
+ * 16 bits, or -1 for delta-encoded blocks.
+ */
+struct fast_comp_dir {
+    int32_t base;
+    int32_t raw_off;
+};
+
 /*
  * Internal tree structure.
  */
@@ -100,14 +250,297 @@ struct fast_tree {
     size_t   layout_size;  /* Number of entries allocated in layout/sorted_rank */
     size_t   tree_nodes;   /* Total nodes in padded complete binary tree (2^d_N - 1) */
     int      d_n;          /* Depth of tree (number of levels) */
+    int      d_k;          /* SIMD blocking depth (2=SSE, 3=AVX2, 4=AVX-512) */
+    int      n_k;          /* Keys per SIMD block (2^d_k - 1) */
+    int      d_l;          /* Cache line blocking depth */
     int      d_p;          /* Page blocking depth (depends on system page size) */
     int      n_p;          /* Keys per page block (2^d_p - 1) */
+    int      d_p2;         /* Superpage (2MB) blocking depth, or FAST_DP2_NONE */
+    int      want_huge;    /* Request hugepage-backed layout allocation */
+    int      build_threads; /* Threads for layout construction (<=1 = serial) */
+    int      from_file;    /* Tree opened via fast_open_mmap (arrays in map) */
+    int      force_scalar; /* Saved d_k wider than this CPU supports */
+    int      prefetch;     /* Prefetch-ahead descent (FAST_PREFETCH=1) */
+    int      hot_pinned;   /* Tiered tree: hot ranges mlocked (fast_tiered.c) */
+
+    /* Non-NULL for arena-resident trees (fast_create_in): all arrays
+       and the struct itself live in the arena and are reclaimed by
+       fast_arena_reset/destroy, never individually freed. */
+    struct fast_arena *arena;
+    int      compact;      /* No sorted_rank; rank recovered from the path */
     size_t   page_size;    /* System page size in bytes */
+    void    *layout_map;   /* Non-NULL if layout is mmap-backed (munmap it) */
+    size_t   layout_map_bytes;
+
+    /* Device-side copy of the tree (layout + keys), uploaded lazily on
+       the first fast_search_batch_gpu call.  NULL until then, and
+       always NULL when the library is built without FAST_ENABLE_CUDA. */
+    void *gpu;
+
+    /* Per-thread counter slots (struct fast_stats_slot[FAST_STATS_SLOTS])
+       in FAST_STATS builds; NULL otherwise. */
+    void *stats;
+
+    /* Incremental inserts (fast_insert): a small sorted buffer merged
+       logically into every search until fast_merge folds it in. */
+    int32_t *delta;
+    size_t   delta_n;
+    size_t   delta_cap;
+
+    /* Associated payloads (fast_create_kv): values[i] belongs to
+       keys[i], stored 64-byte aligned so a payload never straddles an
+       extra cache line.  NULL for key-only trees. */
+    void    *values;
+    size_t   value_size;
+
+    /* NUMA replication (fast_create_numa): one tree per node, probes
+       routed to the caller's local replica.  Slot 0 is the tree itself. */
+    int      numa_replicated;
+    int      numa_nodes;
+    struct fast_tree *numa_replicas[FAST_NUMA_MAX_NODES];
+
+    /* Compressed mode (fast_create_compressed): layout is NULL and the
+       tree is searched through these instead. */
+    int      compressed;
+    uint16_t *comp_deltas;       /* layout_size 16-bit deltas */
+    struct fast_comp_dir *comp_dir;
+    int32_t  *comp_raw;          /* arena of raw fallback blocks */
+    size_t    comp_raw_size;
+    size_t    comp_round_off[8]; /* first block id per page round */
+};
+
+/*
+ * 64-bit key variant.  Field-for-field identical to fast_tree apart
+ * from the key width, so the descent macros and the type-parameterized
+ * build (fast_build_impl.h) apply to both.  Always built compact:
+ * sorted_rank stays NULL and ranks come from the descent path, which
+ * is key-width independent.
+ */
+struct fast64_tree {
+    int64_t *layout;
+    int32_t *sorted_rank;  /* Always NULL; kept for the shared build */
+    int64_t *keys;
+    size_t   n;
+    size_t   layout_size;
+    size_t   tree_nodes;
+    int      d_n;
+    int      d_k;          /* 1=SSE/scalar, 2=AVX2, 3=AVX-512 */
+    int      n_k;
+    int      d_l;
+    int      d_p;
+    int      n_p;
+    int      d_p2;
+    int      want_huge;
+    int      build_threads;
+    int      from_file;
+    int      force_scalar;
+    int      prefetch;
+    int      compact;
+    struct fast_arena *arena;
+    void    *stats;        /* Always NULL; kept for the shared macros */
+    size_t   page_size;
+    void    *layout_map;
+    size_t   layout_map_bytes;
 };
 
+/*
+ * Number of traversals kept in flight by fast_search_batch.  Each
+ * in-flight query owns one outstanding cache miss, so this bounds the
+ * memory-level parallelism we expose; 8 keeps the state well inside
+ * the L1 while saturating typical per-core miss buffers.
+ */
+#define FAST_BATCH_WIDTH 8
+
+/*
+ * The suspended traversal state (struct fast_cursor) lives in fast.h:
+ * it is shared by the software-pipelined batch search here and by the
+ * public coroutine-style fast_search_begin/step API, whose callers
+ * embed one frame per request.
+ */
+#if FAST_HAVE_SSE
+void fast_cursor_init(const struct fast_tree *t, struct fast_cursor *cur,
+                      int32_t key, int lb);
+void fast_cursor_step(const struct fast_tree *t, struct fast_cursor *cur);
+#endif
+
+/*
+ * Map a comparison mask to the child index for a BFS-ordered block of
+ * `depth` levels.  Bit i of `mask` is 1 iff query > block[i].  We walk
+ * the implicit binary tree inside the block: at node b, the mask bit
+ * selects the left or right child.  For depth 2 this reproduces
+ * FAST_LOOKUP; wider blocks (AVX2/AVX-512) would need 128- or
+ * 32768-entry tables, so the 3-4 step walk is used instead.
+ */
+static inline int fast_mask_to_child(unsigned mask, int depth)
+{
+    unsigned node = 0;
+    for (int i = 0; i < depth; i++)
+        node = 2 * node + 1 + ((mask >> node) & 1u);
+    return (int)(node - (((unsigned)1 << depth) - 1));
+}
+
+/* Non-binding cache prefetch hint; compiles away on other compilers. */
+#if defined(__GNUC__) || defined(__clang__)
+#define fast_prefetch(p) __builtin_prefetch((p), 0, 3)
+#else
+#define fast_prefetch(p) ((void)(p))
+#endif
+
+/*
+ * Prefetch-ahead traversal mode, selected per tree at create/open time
+ * by FAST_PREFETCH=1 in the environment (same convention as FAST_SIMD).
+ * The descent then issues prefetches for the candidate child blocks one
+ * blocking level ahead and for the key lines the leaf resolution will
+ * touch; see FAST_PREFETCH_AHEAD in fast_search.c.
+ */
+static inline int fast_env_prefetch(void)
+{
+    const char *e = getenv("FAST_PREFETCH");
+    return e && e[0] == '1';
+}
+
+/*
+ * Bump-pointer arena backing fast_create_in: one caller-sized slab,
+ * persistent allocations (tree struct, keys, layout, rank) bump up from
+ * the bottom while build scratch (child lists, thread tasks) bumps down
+ * from the top and is rewound when the build finishes, so scratch from
+ * thousands of small builds never accumulates.  Exhaustion returns NULL
+ * and fails the build; nothing in an arena is individually freed.
+ */
+struct fast_arena {
+    unsigned char *base;
+    size_t cap;
+    size_t lo;   /* persistent bump, grows up */
+    size_t hi;   /* scratch bump, grows down */
+};
+
+void *fast_arena_lo_alloc(struct fast_arena *a, size_t bytes);
+void *fast_arena_hi_alloc(struct fast_arena *a, size_t bytes);
+
+/* Common degenerate/boundary handling shared by all search kernels. */
+#define FAST_SEARCH_BOUNDS(t, key, result)                                  \
+    do {                                                                    \
+        if ((t)->d_n == 0) {                                                \
+            FAST_STAT_ADD(t, FAST_ST_BOUNDS_EXITS, 1);                      \
+            *(result) = ((t)->n > 0 && (key) >= (t)->keys[0]) ? 0 : -1;     \
+            return;                                                         \
+        }                                                                   \
+        if ((key) < (t)->keys[0]) {                                         \
+            FAST_STAT_ADD(t, FAST_ST_BOUNDS_EXITS, 1);                      \
+            *(result) = -1;                                                 \
+            return;                                                         \
+        }                                                                   \
+        if ((key) >= (t)->keys[(t)->n - 1]) {                               \
+            FAST_STAT_ADD(t, FAST_ST_BOUNDS_EXITS, 1);                      \
+            *(result) = (int64_t)((t)->n - 1);                              \
+            return;                                                         \
+        }                                                                   \
+    } while (0)
+
+/*
+ * Resolve the predecessor of a compact tree (no sorted_rank array) from
+ * the descent's accumulated child-index path.
+ *
+ * The padded tree is a complete BST over the sorted keys, and every
+ * descent step goes right exactly when query > node key, so the d_N-bit
+ * concatenation of all child indices is the number of keys strictly
+ * less than the query — i.e. its lower-bound index.  The predecessor is
+ * the slot before it; the same short forward scan as resolve_leaf()
+ * advances over an exact match and its duplicates.
+ */
+static inline int64_t resolve_path(const struct fast_tree *t,
+                                   int32_t key, size_t path)
+{
+    const int32_t *keys = t->keys;
+    const size_t n = t->n;
+    int64_t lo = (int64_t)path - 1;
+
+    if (lo >= (int64_t)n) lo = (int64_t)n - 1;
+    for (int i = 0; i < 3 && lo + 1 < (int64_t)n; i++) {
+        if (keys[lo + 1] <= key) {
+            lo++;
+            FAST_STAT_ADD(t, FAST_ST_LEAF_SCANS, 1);
+        } else {
+            break;
+        }
+    }
+    return lo;
+}
+
+/* Select SIMD width (d_k/n_k/d_l) for a tree being built. */
+void fast_pick_simd_width(struct fast_tree *t);
+void fast64_pick_simd_width(struct fast64_tree *t);
+
 /* Internal functions */
 int  fast_build_layout(struct fast_tree *t, const int32_t *sorted_keys, size_t n);
+int  fast_sort_into(int32_t *dst, const int32_t *src, size_t n, int nthreads);
 void fast_search_sse(const struct fast_tree *t, int32_t key, int64_t *result);
 void fast_search_scalar(const struct fast_tree *t, int32_t key, int64_t *result);
+void fast_search_batch_sse(const struct fast_tree *t, const int32_t *queries,
+                           size_t m, int64_t *results);
+void fast_lower_bound_batch_sse(const struct fast_tree *t,
+                                const int32_t *queries, size_t m,
+                                int64_t *results);
+#if FAST_HAVE_AVX_DISPATCH
+void fast_search_avx2(const struct fast_tree *t, int32_t key, int64_t *result);
+void fast_search_avx512(const struct fast_tree *t, int32_t key, int64_t *result);
+#endif
+
+#if FAST_HAVE_NEON
+void fast_search_neon(const struct fast_tree *t, int32_t key, int64_t *result);
+#endif
+#if FAST_HAVE_SVE
+void fast_search_sve(const struct fast_tree *t, int32_t key, int64_t *result);
+#endif
+
+/* Lower-bound kernels: the descent path is the successor rank itself. */
+void fast_lower_bound_scalar(const struct fast_tree *t, int32_t key,
+                             int64_t *result);
+#if FAST_HAVE_SSE
+void fast_lower_bound_sse(const struct fast_tree *t, int32_t key,
+                          int64_t *result);
+#endif
+#if FAST_HAVE_AVX_DISPATCH
+void fast_lower_bound_avx2(const struct fast_tree *t, int32_t key,
+                           int64_t *result);
+void fast_lower_bound_avx512(const struct fast_tree *t, int32_t key,
+                             int64_t *result);
+#endif
+
+#if FAST_HAVE_NEON
+void fast_lower_bound_neon(const struct fast_tree *t, int32_t key,
+                           int64_t *result);
+#endif
+#if FAST_HAVE_SVE
+void fast_lower_bound_sve(const struct fast_tree *t, int32_t key,
+                          int64_t *result);
+#endif
+
+/* Delta-buffer helpers (fast_update.c) for the merged logical view. */
+size_t  fast_delta_count_le(const struct fast_tree *t, int32_t key);
+size_t  fast_delta_count_lt(const struct fast_tree *t, int32_t key);
+int32_t fast_merged_key_at(const struct fast_tree *t, size_t index);
+size_t  fast_merged_range_copy(const struct fast_tree *t, int32_t lo,
+                               int32_t hi, int32_t *out, size_t max);
+
+/* Free the device-side tree copy, if any (fast_gpu.cu / stub). */
+void fast_gpu_release(struct fast_tree *t);
+
+int  fast_numa_node_count(void);
+const struct fast_tree *fast_numa_route(const struct fast_tree *t);
+
+int  fast_compress_layout(struct fast_tree *t);
+void fast_search_comp(const struct fast_tree *t, int32_t key, int64_t *result);
+
+int  fast64_build_layout(struct fast64_tree *t, const int64_t *sorted_keys,
+                         size_t n);
+void fast64_search_scalar(const struct fast64_tree *t, int64_t key,
+                          int64_t *result);
+#if FAST_HAVE_AVX_DISPATCH
+void fast64_search_avx2(const struct fast64_tree *t, int64_t key,
+                        int64_t *result);
+void fast64_search_avx512(const struct fast64_tree *t, int64_t key,
+                          int64_t *result);
+#endif
 
 #endif /* FAST_INTERNAL_H */
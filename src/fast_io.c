@@ -0,0 +1,185 @@
+#include "fast_internal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * On-disk tree image.
+ *
+ * The layout, sorted_rank and keys arrays are all position-independent
+ * flat arrays, so a tree can be serialized as a header plus the three
+ * arrays and reopened with a single mmap: no pointers to fix up, no
+ * rebuild.  Startup cost becomes page-fault-on-demand, and multiple
+ * processes mapping the same file share one physical copy through the
+ * page cache.
+ *
+ * Each section is padded to a 4KB boundary so the mapped arrays start
+ * page-aligned (the same alignment the in-memory build uses).
+ */
+
+#define FAST_FILE_MAGIC   0x54534146u  /* "FAST" little-endian */
+/* Version 2: one-level SIMD remainders are folded into d_K + 1 terminal
+   blocks, which changes the layout node order at odd depths. */
+#define FAST_FILE_VERSION 2u
+#define FAST_FILE_ALIGN   4096u
+
+struct fast_file_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t n;
+    uint64_t layout_size;   /* elements in layout / sorted_rank */
+    uint64_t tree_nodes;
+    uint64_t page_size;
+    int32_t  d_n;
+    int32_t  d_k;
+    int32_t  n_k;
+    int32_t  d_l;
+    int32_t  d_p;
+    int32_t  n_p;
+    int32_t  d_p2;
+    int32_t  compact;       /* no sorted_rank section in the image */
+};
+
+static size_t align_up(size_t v, size_t a)
+{
+    return (v + a - 1) & ~(a - 1);
+}
+
+static int write_padded(FILE *f, const void *data, size_t bytes)
+{
+    static const char zeros[FAST_FILE_ALIGN] = {0};
+    size_t padded = align_up(bytes, FAST_FILE_ALIGN);
+
+    if (fwrite(data, 1, bytes, f) != bytes)
+        return -1;
+    if (padded > bytes &&
+        fwrite(zeros, 1, padded - bytes, f) != padded - bytes)
+        return -1;
+    return 0;
+}
+
+int fast_save(const fast_tree_t *tree, const char *path)
+{
+    /* Pending inserts are not in the layout (merge before saving), and
+       the format carries no value section for kv trees. */
+    if (!tree || !path || tree->compressed || tree->delta_n || tree->values)
+        return -1;
+
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return -1;
+
+    struct fast_file_header hdr = {
+        .magic       = FAST_FILE_MAGIC,
+        .version     = FAST_FILE_VERSION,
+        .n           = tree->n,
+        .layout_size = tree->layout_size,
+        .tree_nodes  = tree->tree_nodes,
+        .page_size   = tree->page_size,
+        .d_n         = tree->d_n,
+        .d_k         = tree->d_k,
+        .n_k         = tree->n_k,
+        .d_l         = tree->d_l,
+        .d_p         = tree->d_p,
+        .n_p         = tree->n_p,
+        .d_p2        = tree->d_p2,
+        .compact     = tree->sorted_rank ? 0 : 1,
+    };
+
+    int rc = -1;
+    if (write_padded(f, &hdr, sizeof(hdr)) == 0 &&
+        write_padded(f, tree->layout,
+                     tree->layout_size * sizeof(int32_t)) == 0 &&
+        (hdr.compact ||
+         write_padded(f, tree->sorted_rank,
+                      tree->layout_size * sizeof(int32_t)) == 0) &&
+        write_padded(f, tree->keys, tree->n * sizeof(int32_t)) == 0)
+        rc = 0;
+
+    if (fclose(f) != 0)
+        rc = -1;
+    return rc;
+}
+
+fast_tree_t *fast_open_mmap(const char *path)
+{
+    if (!path)
+        return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct fast_file_header)) {
+        close(fd);
+        return NULL;
+    }
+    size_t file_bytes = (size_t)st.st_size;
+
+    void *map = mmap(NULL, file_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); /* the mapping keeps the file referenced */
+    if (map == MAP_FAILED)
+        return NULL;
+
+    const struct fast_file_header *hdr = (const struct fast_file_header *)map;
+    size_t layout_off = align_up(sizeof(*hdr), FAST_FILE_ALIGN);
+    size_t rank_off, keys_off, need;
+
+    if (hdr->magic != FAST_FILE_MAGIC || hdr->version != FAST_FILE_VERSION)
+        goto bad;
+
+    rank_off = layout_off +
+               align_up(hdr->layout_size * sizeof(int32_t), FAST_FILE_ALIGN);
+    keys_off = hdr->compact
+             ? rank_off
+             : rank_off +
+               align_up(hdr->layout_size * sizeof(int32_t), FAST_FILE_ALIGN);
+    need = keys_off + hdr->n * sizeof(int32_t);
+    if (need > file_bytes)
+        goto bad;
+
+    struct fast_tree *t = (struct fast_tree *)calloc(1, sizeof(struct fast_tree));
+    if (!t)
+        goto bad;
+
+    t->layout      = (int32_t *)((char *)map + layout_off);
+    t->sorted_rank = hdr->compact ? NULL : (int32_t *)((char *)map + rank_off);
+    t->keys        = (int32_t *)((char *)map + keys_off);
+    t->compact     = hdr->compact;
+    t->n           = hdr->n;
+    t->layout_size = hdr->layout_size;
+    t->tree_nodes  = hdr->tree_nodes;
+    t->page_size   = hdr->page_size;
+    t->d_n         = hdr->d_n;
+    t->d_k         = hdr->d_k;
+    t->n_k         = hdr->n_k;
+    t->d_l         = hdr->d_l;
+    t->d_p         = hdr->d_p;
+    t->n_p         = hdr->n_p;
+    t->d_p2        = hdr->d_p2;
+    t->layout_map  = map;
+    t->layout_map_bytes = file_bytes;
+    t->from_file   = 1;
+    t->prefetch    = fast_env_prefetch();
+
+    /* The image may have been written on a wider machine than this
+       one; if the saved SIMD depth exceeds what the CPU supports, the
+       width-generic scalar kernel handles the layout correctly. */
+    {
+        struct fast_tree probe = {0};
+        fast_pick_simd_width(&probe);
+        if (t->d_k > probe.d_k)
+            t->force_scalar = 1;
+    }
+
+    fast_stats_attach(t);
+    return t;
+
+bad:
+    munmap(map, file_bytes);
+    return NULL;
+}
@@ -0,0 +1,176 @@
+/*
+ * Bulk set operators over two trees: intersection and merge join.
+ *
+ * Both trees keep their sorted key arrays, so the core is a two-pointer
+ * merge that runs at memory-scan speed instead of a per-key search
+ * through the public API.  Two escapes keep skewed inputs cheap:
+ * an SSE compare advances the lagging side four keys per step while it
+ * trails, and once a gap survives that linear skip the lagging side
+ * jumps straight to the other side's current key with one lower-bound
+ * descent — so intersecting a small filter tree with a large fact tree
+ * costs the filter's length, not the fact table's.
+ *
+ * The operators visit the trees' built key arrays; like fast_keys_ptr,
+ * keys inserted since the last fast_merge are not visited.
+ */
+
+#include "fast_internal.h"
+
+/* Linear SSE skip gives up after this many keys and gallops instead. */
+#define FAST_JOIN_SKIP_MAX 32
+
+/*
+ * Lower bound within the built key array only (no delta adjustment):
+ * the operators' cursors index t->keys directly.  Same kernel dispatch
+ * as fast_search_lower_bound; compressed trees keep no int32 layout,
+ * so they binary search.
+ */
+static size_t lb_keys(const struct fast_tree *t, int32_t key)
+{
+    int64_t lb;
+
+    if (t->compressed) {
+        const int32_t *keys = t->keys;
+        size_t lo = 0, hi = t->n;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (keys[mid] < key)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+    if (t->force_scalar) {
+        fast_lower_bound_scalar(t, key, &lb);
+        return (size_t)lb;
+    }
+#if FAST_HAVE_AVX_DISPATCH
+    switch (t->d_k) {
+    case FAST_DK_AVX512: fast_lower_bound_avx512(t, key, &lb); break;
+    case FAST_DK_AVX2:   fast_lower_bound_avx2(t, key, &lb);   break;
+    default:             fast_lower_bound_sse(t, key, &lb);    break;
+    }
+#elif FAST_HAVE_SSE
+    fast_lower_bound_sse(t, key, &lb);
+#elif FAST_HAVE_NEON
+#if FAST_HAVE_SVE
+    if (t->d_k > FAST_DK)
+        fast_lower_bound_sve(t, key, &lb);
+    else
+#endif
+        fast_lower_bound_neon(t, key, &lb);
+#else
+    fast_lower_bound_scalar(t, key, &lb);
+#endif
+    return (size_t)lb;
+}
+
+/*
+ * Advance cursor i over keys[] while keys[i] < bound.  SSE compares
+ * four keys per step; past FAST_JOIN_SKIP_MAX the caller gallops.
+ * Returns the new cursor.
+ */
+static size_t skip_below(const int32_t *keys, size_t n, size_t i,
+                         int32_t bound)
+{
+    size_t stop = i + FAST_JOIN_SKIP_MAX;
+    if (stop > n)
+        stop = n;
+
+#if FAST_HAVE_SSE
+    __m128i v_bound = _mm_set1_epi32(bound);
+    while (i + 4 <= stop) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(keys + i));
+        int mask = _mm_movemask_ps(
+            _mm_castsi128_ps(_mm_cmplt_epi32(v, v_bound)));
+        if (mask == 0xF) {
+            i += 4;
+            continue;
+        }
+        /* First lane not below the bound ends the skip. */
+        while (mask & 1) {
+            i++;
+            mask >>= 1;
+        }
+        return i;
+    }
+#elif FAST_HAVE_NEON
+    static const uint32_t bits[4] = { 1, 2, 4, 8 };
+    int32x4_t v_bound = vdupq_n_s32(bound);
+    uint32x4_t v_bits = vld1q_u32(bits);
+    while (i + 4 <= stop) {
+        int32x4_t v = vld1q_s32(keys + i);
+        unsigned mask = vaddvq_u32(vandq_u32(vcltq_s32(v, v_bound), v_bits));
+        if (mask == 0xFu) {
+            i += 4;
+            continue;
+        }
+        while (mask & 1) {
+            i++;
+            mask >>= 1;
+        }
+        return i;
+    }
+#endif
+    while (i < stop && keys[i] < bound)
+        i++;
+    return i;
+}
+
+/*
+ * Shared merge loop.  For every distinct key present in both trees,
+ * emit (key, index of its first occurrence in a, same in b) exactly
+ * once, in ascending key order; duplicates on either side are stepped
+ * over.  `out` collects keys up to `max` when non-NULL, `fn` is called
+ * when non-NULL.  Returns the number of common keys found (for the
+ * intersection path, capped at max).
+ */
+static size_t join_merge(const fast_tree_t *a, const fast_tree_t *b,
+                         int32_t *out, size_t max,
+                         fast_join_fn fn, void *arg)
+{
+    const int32_t *ak = a->keys, *bk = b->keys;
+    const size_t na = a->n, nb = b->n;
+    size_t i = 0, j = 0, found = 0;
+
+    while (i < na && j < nb) {
+        int32_t ka = ak[i], kb = bk[j];
+
+        if (ka == kb) {
+            if (out) {
+                if (found == max)
+                    break;
+                out[found] = ka;
+            }
+            found++;
+            if (fn)
+                fn(ka, (int64_t)i, (int64_t)j, arg);
+            do i++; while (i < na && ak[i] == ka);
+            do j++; while (j < nb && bk[j] == kb);
+        } else if (ka < kb) {
+            size_t ni = skip_below(ak, na, i, kb);
+            i = (ni < na && ak[ni] < kb) ? lb_keys(a, kb) : ni;
+        } else {
+            size_t nj = skip_below(bk, nb, j, ka);
+            j = (nj < nb && bk[nj] < ka) ? lb_keys(b, ka) : nj;
+        }
+    }
+    return found;
+}
+
+size_t fast_intersect(const fast_tree_t *a, const fast_tree_t *b,
+                      int32_t *out, size_t max)
+{
+    if (!a || !b || !out || a->n == 0 || b->n == 0)
+        return 0;
+    return join_merge(a, b, out, max, NULL, NULL);
+}
+
+size_t fast_merge_join(const fast_tree_t *a, const fast_tree_t *b,
+                       fast_join_fn fn, void *arg)
+{
+    if (!a || !b || !fn || a->n == 0 || b->n == 0)
+        return 0;
+    return join_merge(a, b, NULL, 0, fn, arg);
+}
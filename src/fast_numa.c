@@ -0,0 +1,126 @@
+#define _GNU_SOURCE
+#include "fast_internal.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/*
+ * NUMA-aware placement (fast_create_numa).
+ *
+ * A tree built by fast_create lands on whichever node first-touches
+ * the allocation, and remote-socket probes pay a cross-socket latency
+ * penalty on every level below the cache-resident top.  Two policies:
+ *
+ *   FAST_NUMA_INTERLEAVE  spread the layout pages round-robin across
+ *                         all nodes — every socket pays the average
+ *                         rather than the worst case.
+ *   FAST_NUMA_REPLICATE   build one full replica per node and route
+ *                         each search to the caller's local replica,
+ *                         removing cross-socket traffic from the probe
+ *                         path entirely (at nodes × memory cost).
+ *
+ * Placement goes through the mbind syscall directly (the constants are
+ * defined below, as with MAP_HUGETLB in the builder) so there is no
+ * libnuma dependency; on kernels without NUMA support everything
+ * degrades to a plain tree.  Routing uses getcpu(), which is vDSO-fast.
+ */
+
+#ifndef MPOL_BIND
+#define MPOL_BIND       2
+#define MPOL_INTERLEAVE 3
+#endif
+#ifndef MPOL_MF_MOVE
+#define MPOL_MF_MOVE    (1 << 1)
+#endif
+
+/* Count nodes via sysfs; 1 when NUMA is absent. */
+int fast_numa_node_count(void)
+{
+    char path[64];
+    int n = 0;
+
+    while (n < FAST_NUMA_MAX_NODES) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", n);
+        if (access(path, F_OK) != 0)
+            break;
+        n++;
+    }
+    return (n > 0) ? n : 1;
+}
+
+/*
+ * Apply a memory policy to the tree's layout pages, moving any that
+ * were already faulted in.  Best effort: a failing mbind leaves a
+ * correct, merely unplaced, tree.
+ */
+static void numa_place_layout(struct fast_tree *t, int mode,
+                              unsigned long nodemask)
+{
+    void *addr = t->layout_map ? t->layout_map : (void *)t->layout;
+    size_t len = t->layout_map ? t->layout_map_bytes
+                               : t->layout_size * sizeof(int32_t);
+    size_t ps = t->page_size ? t->page_size : 4096;
+    len = (len + ps - 1) & ~(ps - 1);
+
+#ifdef SYS_mbind
+    /* maxnode must not exceed the bits actually in the mask: the
+       kernel copies BITS_TO_LONGS(maxnode) words, and reading past the
+       single-word mask would hand it stack garbage. */
+    syscall(SYS_mbind, addr, len, mode, &nodemask,
+            (unsigned long)(8 * sizeof(nodemask)),
+            (unsigned long)MPOL_MF_MOVE);
+#else
+    (void)addr; (void)len; (void)mode; (void)nodemask;
+#endif
+}
+
+/* Replica for the calling thread's node; the primary when none. */
+const struct fast_tree *fast_numa_route(const struct fast_tree *t)
+{
+    unsigned cpu, node;
+
+    if (getcpu(&cpu, &node) == 0 &&
+        node < (unsigned)t->numa_nodes && t->numa_replicas[node])
+        return t->numa_replicas[node];
+    return t;
+}
+
+fast_tree_t *fast_create_numa(const int32_t *keys, size_t n,
+                              fast_numa_policy_t policy)
+{
+    int nodes = fast_numa_node_count();
+
+    if (nodes <= 1)
+        return fast_create(keys, n);
+
+    fast_tree_t *primary = fast_create(keys, n);
+    if (!primary)
+        return NULL;
+
+    if (policy == FAST_NUMA_INTERLEAVE) {
+        unsigned long mask = 0;
+        for (int i = 0; i < nodes && i < FAST_NUMA_MAX_NODES; i++)
+            mask |= 1ul << i;
+        numa_place_layout(primary, MPOL_INTERLEAVE, mask);
+        return primary;
+    }
+
+    /* FAST_NUMA_REPLICATE: one tree per node, searches routed by the
+       caller's node.  A failed replica build leaves a NULL slot and
+       that node falls back to the primary. */
+    numa_place_layout(primary, MPOL_BIND, 1ul << 0);
+    primary->numa_nodes = nodes;
+    primary->numa_replicated = 1;
+    primary->numa_replicas[0] = primary;
+
+    for (int i = 1; i < nodes && i < FAST_NUMA_MAX_NODES; i++) {
+        fast_tree_t *r = fast_create(keys, n);
+        if (!r)
+            continue;
+        numa_place_layout(r, MPOL_BIND, 1ul << i);
+        primary->numa_replicas[i] = r;
+    }
+    return primary;
+}
@@ -4,10 +4,22 @@
  * FAST tree search following the algorithm in Section 5.1.2 of the
  * SIGMOD 2010 paper.
  *
- * The tree layout is a recursive SIMD-blocked structure: each 3-key
- * block (d_K=2 levels in BFS order) is followed contiguously by its
- * 4 child subtrees.  This lets us compute child offsets with simple
- * arithmetic: child i starts at (offset + 3 + i * child_subtree_size).
+ * The tree layout is hierarchically blocked at three granularities:
+ * page blocks (d_p levels), cache line blocks (d_L levels) and SIMD
+ * blocks (d_K levels).  Because the padded tree is complete, every
+ * subtree of depth d occupies exactly 2^d - 1 contiguous layout slots,
+ * and the same child-offset rule applies at every blocking level:
+ * after descending the top T levels of a block and accumulating child
+ * index c, the child subtree with r levels remaining at that blocking
+ * level starts at
+ *
+ *     base + (2^T - 1) + c * (2^r - 1)
+ *
+ * The descent therefore runs three nested loops (page / cache line /
+ * SIMD), accumulating the child index bits of the inner level to index
+ * into the outer one.  The innermost step is a single SSE compare plus
+ * a mask lookup, so a traversal touches one cache line per d_L levels
+ * and one page per d_p levels.
  *
  * After reaching a leaf block, sorted_rank[] maps the layout position
  * back to the original sorted-array index.  A short forward scan (at
@@ -18,131 +30,538 @@
 #define FAST_CL_CHILDREN         FAST_NL1
 
 /*
- * Resolve the predecessor from a leaf SIMD block (3 keys).
- *
- * child_index partitions the key space into 4 intervals relative to the
- * block's 3 keys [root, left, right] (BFS order, left < root < right):
- *
- *   0: key <= left       → start searching from rank[left] - 1
- *   1: left < key <= root → start from rank[left]
- *   2: root < key <= right → start from rank[root]
- *   3: key > right        → start from rank[right]
+ * In-order node sequences for BFS-ordered complete blocks of depth 1-4.
+ * FAST_INORDER[d][i] is the block-local BFS index of the i-th smallest
+ * key in a block of depth d.
+ */
+static const int FAST_INORDER_1[1]  = { 0 };
+static const int FAST_INORDER_2[3]  = { 1, 0, 2 };
+static const int FAST_INORDER_3[7]  = { 3, 1, 4, 0, 5, 2, 6 };
+static const int FAST_INORDER_4[15] = { 7, 3, 8, 1, 9, 4, 10, 0,
+                                        11, 5, 12, 2, 13, 6, 14 };
+static const int *const FAST_INORDER[5] = {
+    NULL, FAST_INORDER_1, FAST_INORDER_2, FAST_INORDER_3, FAST_INORDER_4
+};
+
+/*
+ * Resolve the predecessor from a leaf block of `depth` levels.
  *
- * Then scan forward (at most 2 positions) checking keys[pos+1] <= key.
+ * child_index c partitions the key space into 2^depth intervals between
+ * the block's keys taken in sorted (in-order) order.  The in-block
+ * predecessor of the query is the (c-1)-th in-order node; for c == 0
+ * the predecessor lies just before the block's smallest key.  The true
+ * global predecessor can still be an ancestor on the block's boundary
+ * (or the exact match itself), so scan forward while keys[lo+1] <= key.
  */
-static inline int64_t resolve_simd_leaf(const struct fast_tree *t,
-                                        int32_t key, size_t offset,
-                                        int child_index)
+static inline int64_t resolve_leaf(const struct fast_tree *t,
+                                   int32_t key, size_t offset,
+                                   int child_index, int depth)
 {
     const int32_t *keys = t->keys;
     const int32_t *rank = t->sorted_rank;
+    const int *inorder = FAST_INORDER[depth];
     const size_t n = t->n;
     int64_t lo;
 
-    switch (child_index) {
-    case 0:  lo = (int64_t)rank[offset + 1] - 1; break;
-    case 1:  lo = (int64_t)rank[offset + 1];      break;
-    case 2:  lo = (int64_t)rank[offset];           break;
-    default: lo = (int64_t)rank[offset + 2];       break;
-    }
+    if (child_index == 0)
+        lo = (int64_t)rank[offset + inorder[0]] - 1;
+    else
+        lo = (int64_t)rank[offset + inorder[child_index - 1]];
 
     /* Clamp and scan forward to find exact predecessor */
     if (lo < -1) lo = -1;
     if (lo >= (int64_t)n) lo = (int64_t)n - 1;
     for (int i = 0; i < 3 && lo + 1 < (int64_t)n; i++) {
-        if (keys[lo + 1] <= key)
+        if (keys[lo + 1] <= key) {
             lo++;
-        else
+            FAST_STAT_ADD(t, FAST_ST_LEAF_SCANS, 1);
+        } else {
             break;
+        }
     }
     return lo;
 }
 
-/* Resolve from a single-key leaf node. */
-static inline int64_t resolve_single_leaf(const struct fast_tree *t,
-                                          int32_t key, size_t offset,
-                                          int child_index)
+/*
+ * Shared descent skeleton.
+ *
+ * Every kernel runs the same four nested blocking loops — superpage
+ * (d_p2) / page (d_p) / cache line (d_l) / SIMD — and differs only in
+ * how a block is compared against the query, so the loop structure is
+ * expanded from this macro around the kernel's block-compare statement.
+ * The statement sees `base_k` (block base) and `b` (block depth) and
+ * must set `child_index`.  At the bottom of a cache line block or of
+ * the tree, b may be smaller than d_K — or one level larger: a
+ * SIMD-level remainder of d_K + 1 levels is folded into a single
+ * terminal block rather than split into a full block plus a one-key
+ * tail.  The fold acts only within one cache-line round: when the
+ * cache-line remainder itself is a single level (t_l == 1, e.g. a page
+ * remainder of 1 mod d_l), that round still ends on a one-key block.
+ * Kernels whose
+ * register cannot cover 2^(d_K+1) - 1 keys handle the folded depth
+ * with a second overlapping load (the two share the middle node, whose
+ * mask bit both loads compute identically).  On exit `base_k`, `child_index` and
+ * `leaf_depth` describe the final block for resolve_leaf(), and `path`
+ * holds the full d_N-bit child-index sequence for resolve_path().
+ *
+ * For trees without superpage blocking d_p2 is FAST_DP2_NONE, the
+ * min() makes the whole tree one superpage block and the outer loop
+ * runs exactly once.
+ */
+/*
+ * Prefetch-ahead hook (tree->prefetch, set by FAST_PREFETCH=1).
+ *
+ * The descent is a chain of serially dependent loads: the child offset
+ * is only known once the compare on the current block retires.  But at
+ * the SIMD block that decides a blocking-level transition, all 2^b
+ * candidate child blocks are pure arithmetic on values already in
+ * registers, so we issue a prefetch for each candidate before the
+ * compare — one will be the real child, and its line (or page walk)
+ * overlaps the compare and the child-offset computation.  At the final
+ * block of the whole descent the candidate ranks span one 2^b-wide
+ * window of the key array, so the key lines (and the current block's
+ * rank-table line) the resolution will touch are prefetched instead.
+ * Superpage transitions are left alone: they occur once per 2MB of
+ * descent and their children span distinct pages anyway.
+ */
+#define FAST_PREFETCH_AHEAD(t, b)                                           \
+    do {                                                                    \
+        if (rem_k != (b)) break;        /* only the deciding block */       \
+        size_t pf_n = ((size_t)1) << (b);                                   \
+        if (rem_l > t_l) {              /* next cache line block */         \
+            size_t pf_base = base_l + ((((size_t)1) << t_l) - 1);           \
+            size_t pf_sub = ((((size_t)1) << (rem_l - t_l)) - 1);           \
+            size_t pf_c = c_l << (b);                                       \
+            for (size_t pf = 0; pf < pf_n; pf++)                            \
+                fast_prefetch((t)->layout + pf_base + (pf_c + pf) * pf_sub);\
+        } else if (rem_p > t_p) {       /* next page block */               \
+            size_t pf_base = base_p + ((((size_t)1) << t_p) - 1);           \
+            size_t pf_sub = ((((size_t)1) << (rem_p - t_p)) - 1);           \
+            size_t pf_c = (((c_p << (t_l - (b))) | c_l) << (b));            \
+            for (size_t pf = 0; pf < pf_n; pf++)                            \
+                fast_prefetch((t)->layout + pf_base + (pf_c + pf) * pf_sub);\
+        } else if (rem_s == t_s) {      /* final block: leaf resolution */  \
+            size_t est = path;                                              \
+            est = (est << (t_s - rem_p)) | c_s;                             \
+            est = (est << (t_p - rem_l)) | c_p;                             \
+            est = (est << (t_l - rem_k)) | c_l;                             \
+            est <<= (b);                                                    \
+            if (est > 0) est--;         /* predecessor sits one left */     \
+            if (est >= (t)->n) est = (t)->n - 1;                            \
+            fast_prefetch((t)->keys + est);                                 \
+            fast_prefetch((t)->keys + est + pf_n);                          \
+            if ((t)->sorted_rank)                                           \
+                fast_prefetch((t)->sorted_rank + base_k);                   \
+        }                                                                   \
+    } while (0)
+
+#define FAST_DESCEND(t, d_n, DK, ...)                                       \
+    size_t base_s = 0, base_p = 0, base_l = 0, base_k = 0;                  \
+    size_t c_s, c_p, c_l, path = 0;                                         \
+    int rem_s = (d_n);                                                      \
+    int child_index = 0;                                                    \
+    int leaf_depth = (DK);                                                  \
+    FAST_STAT_ADD(t, FAST_ST_SEARCHES, 1);                                  \
+    FAST_STAT_ADD(t, FAST_ST_LEVELS, (d_n));                                \
+    while (rem_s > 0) {                                                     \
+        int t_s = (rem_s < (t)->d_p2) ? rem_s : (t)->d_p2;                  \
+        int rem_p = t_s;                                                    \
+        c_s = 0;                                                            \
+        base_p = base_s;                                                    \
+        while (rem_p > 0) {                                                 \
+            int t_p = (rem_p < (t)->d_p) ? rem_p : (t)->d_p;                \
+            int rem_l = t_p;                                                \
+            c_p = 0;                                                        \
+            base_l = base_p;                                                \
+            while (rem_l > 0) {                                             \
+                int t_l = (rem_l < (t)->d_l) ? rem_l : (t)->d_l;            \
+                int rem_k = t_l;                                            \
+                c_l = 0;                                                    \
+                base_k = base_l;                                            \
+                while (rem_k > 0) {                                         \
+                    int b = (rem_k <= (DK) + 1) ? rem_k : (DK);             \
+                    if ((t)->prefetch)                                      \
+                        FAST_PREFETCH_AHEAD(t, b);                          \
+                    { __VA_ARGS__ }                                         \
+                    rem_k -= b;                                             \
+                    leaf_depth = b;                                         \
+                    c_l = (c_l << b) | (size_t)child_index;                 \
+                    if (rem_k > 0)                                          \
+                        base_k += ((((size_t)1) << b) - 1) +                \
+                            (size_t)child_index * ((((size_t)1) << rem_k) - 1); \
+                }                                                           \
+                rem_l -= t_l;                                               \
+                c_p = (c_p << t_l) | c_l;                                   \
+                if (rem_l > 0)                                              \
+                    base_l += ((((size_t)1) << t_l) - 1) +                  \
+                              c_l * ((((size_t)1) << rem_l) - 1);           \
+            }                                                               \
+            rem_p -= t_p;                                                   \
+            c_s = (c_s << t_p) | c_p;                                       \
+            if (rem_p > 0)                                                  \
+                base_p += ((((size_t)1) << t_p) - 1) +                      \
+                          c_p * ((((size_t)1) << rem_p) - 1);               \
+        }                                                                   \
+        path = (path << t_s) | c_s;                                         \
+        rem_s -= t_s;                                                       \
+        if (rem_s > 0)                                                      \
+            base_s += ((((size_t)1) << t_s) - 1) +                          \
+                      c_s * ((((size_t)1) << rem_s) - 1);                   \
+    }
+
+/*
+ * Final resolution after FAST_DESCEND: the rank table when the tree has
+ * one, path arithmetic for compact trees.
+ */
+#define FAST_RESOLVE(t, key)                                                \
+    ((t)->sorted_rank                                                       \
+         ? resolve_leaf((t), (key), base_k, child_index, leaf_depth)        \
+         : resolve_path((t), (key), path))
+
+#if FAST_HAVE_SSE
+
+void fast_search_sse(const struct fast_tree *t, int32_t key, int64_t *result)
 {
-    const int32_t *keys = t->keys;
-    const int32_t *rank = t->sorted_rank;
-    const size_t n = t->n;
-    int64_t lo;
+    const int32_t *tree = t->layout;
 
-    if (child_index == 0)
-        lo = (int64_t)rank[offset] - 1;
-    else
-        lo = (int64_t)rank[offset];
+    FAST_SEARCH_BOUNDS(t, key, result);
 
-    if (lo < -1) lo = -1;
-    if (lo >= (int64_t)n) lo = (int64_t)n - 1;
-    for (int i = 0; i < 2 && lo + 1 < (int64_t)n; i++) {
-        if (keys[lo + 1] <= key)
-            lo++;
-        else
-            break;
-    }
-    return lo;
+    __m128i v_key = _mm_set1_epi32(key);
+    FAST_DESCEND(t, t->d_n, FAST_DK,
+        __m128i v_tree = _mm_loadu_si128((const __m128i *)(tree + base_k));
+        __m128i v_cmp = _mm_cmpgt_epi32(v_key, v_tree);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(v_cmp));
+        if (b > FAST_DK) {
+            /* Folded 3-level terminal block: second load covers the
+               bottom row, sharing the middle node with the first. */
+            __m128i v_hi = _mm_loadu_si128(
+                (const __m128i *)(tree + base_k + FAST_NK));
+            mask |= _mm_movemask_ps(_mm_castsi128_ps(
+                _mm_cmpgt_epi32(v_key, v_hi))) << FAST_NK;
+            child_index = fast_mask_to_child((unsigned)mask, b);
+        } else {
+            child_index = (b == FAST_DK) ? FAST_LOOKUP[mask & 0x7]
+                                         : (int)(mask & 0x1);
+        }
+    )
+
+    *result = FAST_RESOLVE(t, key);
 }
 
-#if FAST_HAVE_SSE
+/*
+ * AVX2 / AVX-512 kernels: same nested descent, wider blocks.  These are
+ * compiled with per-function target attributes and only ever invoked on
+ * trees whose layout was built with the matching d_k, as selected by
+ * CPUID at fast_create time.  A block at the bottom of a cache line or
+ * of the tree may be shallower than d_k; the full-width load is still
+ * safe (the layout is padded for the widest load) and fast_mask_to_child
+ * only consumes the mask bits of nodes inside the block.  At these
+ * widths d_L never exceeds d_K, so the folded d_K + 1 terminal depth of
+ * the narrower kernels cannot arise and no second load is needed.
+ */
+#if FAST_HAVE_AVX_DISPATCH
 
-void fast_search_sse(const struct fast_tree *t, int32_t key, int64_t *result)
+__attribute__((target("avx2")))
+void fast_search_avx2(const struct fast_tree *t, int32_t key, int64_t *result)
+{
+    const int32_t *tree = t->layout;
+
+    FAST_SEARCH_BOUNDS(t, key, result);
+
+    __m256i v_key = _mm256_set1_epi32(key);
+    FAST_DESCEND(t, t->d_n, FAST_DK_AVX2,
+        __m256i v_tree = _mm256_loadu_si256((const __m256i *)(tree + base_k));
+        __m256i v_cmp = _mm256_cmpgt_epi32(v_key, v_tree);
+        unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(v_cmp));
+        child_index = fast_mask_to_child(mask, b);
+    )
+
+    *result = FAST_RESOLVE(t, key);
+}
+
+__attribute__((target("avx512f")))
+void fast_search_avx512(const struct fast_tree *t, int32_t key, int64_t *result)
 {
     const int32_t *tree = t->layout;
-    const int d_n = t->d_n;
 
-    if (d_n == 0) {
-        *result = (t->n > 0 && key >= t->keys[0]) ? 0 : -1;
+    FAST_SEARCH_BOUNDS(t, key, result);
+
+    __m512i v_key = _mm512_set1_epi32(key);
+    FAST_DESCEND(t, t->d_n, FAST_DK_AVX512,
+        __m512i v_tree = _mm512_loadu_si512((const void *)(tree + base_k));
+        unsigned mask = (unsigned)_mm512_cmpgt_epi32_mask(v_key, v_tree);
+        child_index = fast_mask_to_child(mask, b);
+    )
+
+    *result = FAST_RESOLVE(t, key);
+}
+
+#endif /* FAST_HAVE_AVX_DISPATCH */
+
+/*
+ * Software-pipelined batch search (Section 5.1.3 of the paper).
+ *
+ * A single traversal is a chain of dependent loads: the child offset is
+ * only known once the compare on the current SIMD block retires, so
+ * every level below the cache-resident top costs a full memory round
+ * trip.  With many independent queries we can instead keep
+ * FAST_BATCH_WIDTH traversals in flight: advance query i by one SIMD
+ * block, prefetch its next block, and move on to query i+1 while the
+ * prefetch is outstanding.  The per-query state lives in a fast_cursor,
+ * which flattens the three nested descent loops of fast_search_sse into
+ * one resumable frame per blocking level.
+ */
+
+void fast_cursor_init(const struct fast_tree *t, struct fast_cursor *cur,
+                      int32_t key, int lb)
+{
+    cur->key = key;
+    cur->lb = lb;
+    cur->done = 0;
+
+    /* Boundary ranks differ between the predecessor and lower-bound
+       searches; the descent below them is identical. */
+    if (t->d_n == 0) {
+        FAST_STAT_ADD(t, FAST_ST_BOUNDS_EXITS, 1);
+        cur->result = lb ? 0 : ((t->n > 0 && key >= t->keys[0]) ? 0 : -1);
+        cur->done = 1;
         return;
     }
-
-    /* Boundary checks */
-    if (key < t->keys[0]) {
-        *result = -1;
+    if (lb ? (key <= t->keys[0]) : (key < t->keys[0])) {
+        FAST_STAT_ADD(t, FAST_ST_BOUNDS_EXITS, 1);
+        cur->result = lb ? 0 : -1;
+        cur->done = 1;
         return;
     }
-    if (key >= t->keys[t->n - 1]) {
-        *result = (int64_t)(t->n - 1);
+    if (lb ? (key > t->keys[t->n - 1]) : (key >= t->keys[t->n - 1])) {
+        FAST_STAT_ADD(t, FAST_ST_BOUNDS_EXITS, 1);
+        cur->result = (int64_t)(lb ? t->n : t->n - 1);
+        cur->done = 1;
         return;
     }
 
+    FAST_STAT_ADD(t, FAST_ST_SEARCHES, 1);
+    FAST_STAT_ADD(t, FAST_ST_LEVELS, t->d_n);
+    cur->path = 0;
+    cur->base_s = 0;
+    cur->rem_s = t->d_n;
+    cur->t_s = (cur->rem_s < t->d_p2) ? cur->rem_s : t->d_p2;
+    cur->base_p = 0;
+    cur->rem_p = cur->t_s;
+    cur->c_s = 0;
+    cur->t_p = (cur->rem_p < t->d_p) ? cur->rem_p : t->d_p;
+    cur->base_l = 0;
+    cur->rem_l = cur->t_p;
+    cur->c_p = 0;
+    cur->t_l = (cur->rem_l < t->d_l) ? cur->rem_l : t->d_l;
+    cur->base_k = 0;
+    cur->rem_k = cur->t_l;
+    cur->c_l = 0;
+    cur->child_index = 0;
+    cur->leaf_depth = t->d_k;
+}
+
+/*
+ * Block compare helpers for the width-generic cursor step.  Each
+ * returns the greater-than mask for one SIMD block; the caller indexes
+ * only the bits of nodes actually inside the block.
+ */
+static inline unsigned block_mask_sse(const int32_t *blk, int32_t key)
+{
     __m128i v_key = _mm_set1_epi32(key);
-    size_t offset = 0;
-    int depth_remaining = d_n;
-    int child_index = 0;
-    int last_block_type = 0; /* 0 = simd (3 keys), 1 = single key */
+    __m128i v_tree = _mm_loadu_si128((const __m128i *)blk);
+    __m128i v_cmp = _mm_cmpgt_epi32(v_key, v_tree);
+    return (unsigned)_mm_movemask_ps(_mm_castsi128_ps(v_cmp));
+}
 
-    while (depth_remaining > 0) {
-        int simd_depth = (depth_remaining >= FAST_DK) ? FAST_DK : depth_remaining;
+#if FAST_HAVE_AVX_DISPATCH
+__attribute__((target("avx2")))
+static unsigned block_mask_avx2(const int32_t *blk, int32_t key)
+{
+    __m256i v_key = _mm256_set1_epi32(key);
+    __m256i v_tree = _mm256_loadu_si256((const __m256i *)blk);
+    __m256i v_cmp = _mm256_cmpgt_epi32(v_key, v_tree);
+    return (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(v_cmp));
+}
 
-        if (simd_depth == FAST_DK) {
-            __m128i v_tree = _mm_loadu_si128((const __m128i *)(tree + offset));
-            __m128i v_cmp = _mm_cmpgt_epi32(v_key, v_tree);
-            int mask = _mm_movemask_ps(_mm_castsi128_ps(v_cmp));
-            child_index = FAST_LOOKUP[mask & 0x7];
+__attribute__((target("avx512f")))
+static unsigned block_mask_avx512(const int32_t *blk, int32_t key)
+{
+    __m512i v_key = _mm512_set1_epi32(key);
+    __m512i v_tree = _mm512_loadu_si512((const void *)blk);
+    return (unsigned)_mm512_cmpgt_epi32_mask(v_key, v_tree);
+}
+#endif
 
-            depth_remaining -= FAST_DK;
-            last_block_type = 0;
+static inline unsigned cursor_block_mask(const struct fast_tree *t,
+                                         const int32_t *blk, int32_t key)
+{
+#if FAST_HAVE_AVX_DISPATCH
+    if (t->d_k == FAST_DK_AVX512)
+        return block_mask_avx512(blk, key);
+    if (t->d_k == FAST_DK_AVX2)
+        return block_mask_avx2(blk, key);
+#endif
+    return block_mask_sse(blk, key);
+}
 
-            if (depth_remaining <= 0)
-                break;
+/*
+ * Advance one SIMD-block step (plus any block-boundary bookkeeping).
+ * On return either cur->done is set with cur->result valid, or the
+ * next block to visit is at cur->base_k and has been prefetched.
+ */
+void fast_cursor_step(const struct fast_tree *t, struct fast_cursor *cur)
+{
+    const int32_t *tree = t->layout;
 
-            size_t child_subtree_size = ((size_t)1 << depth_remaining) - 1;
-            offset = offset + FAST_NK + (size_t)child_index * child_subtree_size;
+    FAST_STAT_ADD(t, FAST_ST_BATCH_STEPS, 1);
+
+    {
+        int b = (cur->rem_k <= t->d_k + 1) ? cur->rem_k : t->d_k;
+        unsigned mask = cursor_block_mask(t, tree + cur->base_k, cur->key);
+        if (b > t->d_k) {
+            /* Folded terminal block: merge the second overlapping load's
+               mask, as the direct kernels do. */
+            unsigned half = (1u << (b - 1)) - 1;
+            mask |= cursor_block_mask(t, tree + cur->base_k + half,
+                                      cur->key) << half;
+        }
+        cur->child_index = fast_mask_to_child(mask, b);
 
-        } else {
-            /* Single key (depth_remaining was 1) */
-            child_index = (key > tree[offset]) ? 1 : 0;
-            depth_remaining -= 1;
-            last_block_type = 1;
-            break;
+        cur->rem_k -= b;
+        cur->leaf_depth = b;
+        cur->c_l = (cur->c_l << b) | (size_t)cur->child_index;
+
+        if (cur->rem_k > 0) {
+            cur->base_k += ((((size_t)1) << b) - 1) +
+                (size_t)cur->child_index * ((((size_t)1) << cur->rem_k) - 1);
+            _mm_prefetch((const char *)(tree + cur->base_k), _MM_HINT_T0);
+            return;
         }
     }
 
-    if (last_block_type == 0)
-        *result = resolve_simd_leaf(t, key, offset, child_index);
+    /* Cache line block exhausted */
+    cur->rem_l -= cur->t_l;
+    cur->c_p = (cur->c_p << cur->t_l) | cur->c_l;
+    if (cur->rem_l > 0) {
+        cur->base_l += ((((size_t)1) << cur->t_l) - 1) +
+                       cur->c_l * ((((size_t)1) << cur->rem_l) - 1);
+        cur->t_l = (cur->rem_l < t->d_l) ? cur->rem_l : t->d_l;
+        cur->base_k = cur->base_l;
+        cur->rem_k = cur->t_l;
+        cur->c_l = 0;
+        _mm_prefetch((const char *)(tree + cur->base_k), _MM_HINT_T0);
+        return;
+    }
+
+    /* Page block exhausted */
+    cur->rem_p -= cur->t_p;
+    cur->c_s = (cur->c_s << cur->t_p) | cur->c_p;
+    if (cur->rem_p > 0) {
+        cur->base_p += ((((size_t)1) << cur->t_p) - 1) +
+                       cur->c_p * ((((size_t)1) << cur->rem_p) - 1);
+        cur->t_p = (cur->rem_p < t->d_p) ? cur->rem_p : t->d_p;
+        cur->base_l = cur->base_p;
+        cur->rem_l = cur->t_p;
+        cur->c_p = 0;
+        cur->t_l = (cur->rem_l < t->d_l) ? cur->rem_l : t->d_l;
+        cur->base_k = cur->base_l;
+        cur->rem_k = cur->t_l;
+        cur->c_l = 0;
+        _mm_prefetch((const char *)(tree + cur->base_k), _MM_HINT_T0);
+        return;
+    }
+
+    /* Superpage block exhausted */
+    cur->path = (cur->path << cur->t_s) | cur->c_s;
+    cur->rem_s -= cur->t_s;
+    if (cur->rem_s > 0) {
+        cur->base_s += ((((size_t)1) << cur->t_s) - 1) +
+                       cur->c_s * ((((size_t)1) << cur->rem_s) - 1);
+        cur->t_s = (cur->rem_s < t->d_p2) ? cur->rem_s : t->d_p2;
+        cur->base_p = cur->base_s;
+        cur->rem_p = cur->t_s;
+        cur->c_s = 0;
+        cur->t_p = (cur->rem_p < t->d_p) ? cur->rem_p : t->d_p;
+        cur->base_l = cur->base_p;
+        cur->rem_l = cur->t_p;
+        cur->c_p = 0;
+        cur->t_l = (cur->rem_l < t->d_l) ? cur->rem_l : t->d_l;
+        cur->base_k = cur->base_l;
+        cur->rem_k = cur->t_l;
+        cur->c_l = 0;
+        _mm_prefetch((const char *)(tree + cur->base_k), _MM_HINT_T0);
+        return;
+    }
+
+    /* Descent complete: resolve against the sorted keys.  The lower
+       bound is the accumulated path itself (see the dedicated
+       lower-bound kernels), with no key-array resolve at all. */
+    if (cur->lb)
+        cur->result = (int64_t)cur->path;
     else
-        *result = resolve_single_leaf(t, key, offset, child_index);
+        cur->result = t->sorted_rank
+            ? resolve_leaf(t, cur->key, cur->base_k,
+                           cur->child_index, cur->leaf_depth)
+            : resolve_path(t, cur->key, cur->path);
+    cur->done = 1;
+}
+
+static void batch_pipeline(const struct fast_tree *t, const int32_t *queries,
+                           size_t m, int64_t *results, int lb)
+{
+    struct fast_cursor cursors[FAST_BATCH_WIDTH];
+    size_t slot_query[FAST_BATCH_WIDTH];
+    size_t next = 0;       /* next query to admit */
+    size_t in_flight = 0;
+
+    size_t width = (m < FAST_BATCH_WIDTH) ? m : FAST_BATCH_WIDTH;
+
+    for (size_t s = 0; s < width; s++) {
+        slot_query[s] = next;
+        fast_cursor_init(t, &cursors[s], queries[next], lb);
+        next++;
+        in_flight++;
+    }
+
+    /* Round-robin: step each live cursor once per pass; a finished slot
+       immediately admits the next pending query so the pipeline stays
+       full until the tail of the batch. */
+    while (in_flight > 0) {
+        FAST_STAT_ADD(t, FAST_ST_BATCH_ROUNDS, 1);
+        for (size_t s = 0; s < width; s++) {
+            struct fast_cursor *cur = &cursors[s];
+            if (cur->done) {
+                if (slot_query[s] == SIZE_MAX)
+                    continue;
+                results[slot_query[s]] = cur->result;
+                if (next < m) {
+                    slot_query[s] = next;
+                    fast_cursor_init(t, cur, queries[next], lb);
+                    next++;
+                } else {
+                    slot_query[s] = SIZE_MAX;
+                    in_flight--;
+                    continue;
+                }
+            }
+            if (!cur->done)
+                fast_cursor_step(t, cur);
+        }
+    }
+}
+
+void fast_search_batch_sse(const struct fast_tree *t, const int32_t *queries,
+                           size_t m, int64_t *results)
+{
+    batch_pipeline(t, queries, m, results, 0);
+}
+
+void fast_lower_bound_batch_sse(const struct fast_tree *t,
+                                const int32_t *queries, size_t m,
+                                int64_t *results)
+{
+    batch_pipeline(t, queries, m, results, 1);
 }
 
 #else /* !FAST_HAVE_SSE */
@@ -152,6 +571,21 @@ void fast_search_sse(const struct fast_tree *t, int32_t key, int64_t *result)
     fast_search_scalar(t, key, result);
 }
 
+void fast_search_batch_sse(const struct fast_tree *t, const int32_t *queries,
+                           size_t m, int64_t *results)
+{
+    for (size_t i = 0; i < m; i++)
+        fast_search_scalar(t, queries[i], &results[i]);
+}
+
+void fast_lower_bound_batch_sse(const struct fast_tree *t,
+                                const int32_t *queries, size_t m,
+                                int64_t *results)
+{
+    for (size_t i = 0; i < m; i++)
+        fast_lower_bound_scalar(t, queries[i], &results[i]);
+}
+
 #endif /* FAST_HAVE_SSE */
 
 /*
@@ -160,60 +594,373 @@ void fast_search_sse(const struct fast_tree *t, int32_t key, int64_t *result)
 void fast_search_scalar(const struct fast_tree *t, int32_t key, int64_t *result)
 {
     const int32_t *tree = t->layout;
-    const int d_n = t->d_n;
 
-    if (d_n == 0) {
-        *result = (t->n > 0 && key >= t->keys[0]) ? 0 : -1;
-        return;
-    }
+    FAST_SEARCH_BOUNDS(t, key, result);
 
-    if (key < t->keys[0]) {
-        *result = -1;
-        return;
-    }
-    if (key >= t->keys[t->n - 1]) {
-        *result = (int64_t)(t->n - 1);
-        return;
-    }
+    FAST_DESCEND(t, t->d_n, t->d_k,
+        /* Walk the block's implicit binary tree node by node;
+           equivalent to the SIMD compare + mask walk. */
+        unsigned node = 0;
+        for (int i = 0; i < b; i++)
+            node = 2 * node + 1 + (key > tree[base_k + node] ? 1u : 0u);
+        child_index = (int)(node - (((unsigned)1 << b) - 1));
+    )
+
+    *result = FAST_RESOLVE(t, key);
+}
+
+/*
+ * Dedicated lower-bound kernels.
+ *
+ * Every descent step goes right exactly when query > node key, so the
+ * accumulated path is the number of keys strictly below the query —
+ * which is the lower-bound rank itself.  Unlike the predecessor
+ * kernels there is no resolve step: no rank-table lookup, no forward
+ * scan over t->keys, just the descent and the path.  The boundary
+ * checks differ from FAST_SEARCH_BOUNDS only in their return ranks
+ * (0 for queries at or below the smallest key, n above the largest).
+ */
+#define FAST_LOWER_BOUND_BOUNDS(t, key, result)                             \
+    do {                                                                    \
+        if ((key) <= (t)->keys[0]) {                                        \
+            FAST_STAT_ADD(t, FAST_ST_BOUNDS_EXITS, 1);                      \
+            *(result) = 0;                                                  \
+            return;                                                         \
+        }                                                                   \
+        if ((key) > (t)->keys[(t)->n - 1]) {                                \
+            FAST_STAT_ADD(t, FAST_ST_BOUNDS_EXITS, 1);                      \
+            *(result) = (int64_t)(t)->n;                                    \
+            return;                                                         \
+        }                                                                   \
+    } while (0)
+
+void fast_lower_bound_scalar(const struct fast_tree *t, int32_t key,
+                             int64_t *result)
+{
+    const int32_t *tree = t->layout;
 
-    size_t offset = 0;
-    int depth_remaining = d_n;
-    int child_index = 0;
-    int last_block_type = 0;
+    FAST_LOWER_BOUND_BOUNDS(t, key, result);
 
-    while (depth_remaining > 0) {
-        int simd_depth = (depth_remaining >= FAST_DK) ? FAST_DK : depth_remaining;
+    FAST_DESCEND(t, t->d_n, t->d_k,
+        unsigned node = 0;
+        for (int i = 0; i < b; i++)
+            node = 2 * node + 1 + (key > tree[base_k + node] ? 1u : 0u);
+        child_index = (int)(node - (((unsigned)1 << b) - 1));
+    )
 
-        if (simd_depth >= 2) {
-            int32_t k0 = tree[offset];      /* root */
-            int32_t k1 = tree[offset + 1];  /* left child */
-            int32_t k2 = tree[offset + 2];  /* right child */
+    (void)leaf_depth;
+    *result = (int64_t)path;
+}
 
-            if (key <= k0) {
-                child_index = (key <= k1) ? 0 : 1;
-            } else {
-                child_index = (key <= k2) ? 2 : 3;
-            }
+#if FAST_HAVE_SSE
+
+void fast_lower_bound_sse(const struct fast_tree *t, int32_t key,
+                          int64_t *result)
+{
+    const int32_t *tree = t->layout;
+
+    FAST_LOWER_BOUND_BOUNDS(t, key, result);
+
+    __m128i v_key = _mm_set1_epi32(key);
+    FAST_DESCEND(t, t->d_n, FAST_DK,
+        __m128i v_tree = _mm_loadu_si128((const __m128i *)(tree + base_k));
+        __m128i v_cmp = _mm_cmpgt_epi32(v_key, v_tree);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(v_cmp));
+        if (b > FAST_DK) {
+            /* Folded 3-level terminal block: second load covers the
+               bottom row, sharing the middle node with the first. */
+            __m128i v_hi = _mm_loadu_si128(
+                (const __m128i *)(tree + base_k + FAST_NK));
+            mask |= _mm_movemask_ps(_mm_castsi128_ps(
+                _mm_cmpgt_epi32(v_key, v_hi))) << FAST_NK;
+            child_index = fast_mask_to_child((unsigned)mask, b);
+        } else {
+            child_index = (b == FAST_DK) ? FAST_LOOKUP[mask & 0x7]
+                                         : (int)(mask & 0x1);
+        }
+    )
 
-            depth_remaining -= 2;
-            last_block_type = 0;
+    (void)leaf_depth;
+    *result = (int64_t)path;
+}
+
+#if FAST_HAVE_AVX_DISPATCH
+
+__attribute__((target("avx2")))
+void fast_lower_bound_avx2(const struct fast_tree *t, int32_t key,
+                           int64_t *result)
+{
+    const int32_t *tree = t->layout;
+
+    FAST_LOWER_BOUND_BOUNDS(t, key, result);
+
+    __m256i v_key = _mm256_set1_epi32(key);
+    FAST_DESCEND(t, t->d_n, FAST_DK_AVX2,
+        __m256i v_tree = _mm256_loadu_si256((const __m256i *)(tree + base_k));
+        unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(
+            _mm256_cmpgt_epi32(v_key, v_tree)));
+        child_index = fast_mask_to_child(mask, b);
+    )
+
+    (void)leaf_depth;
+    *result = (int64_t)path;
+}
+
+__attribute__((target("avx512f")))
+void fast_lower_bound_avx512(const struct fast_tree *t, int32_t key,
+                             int64_t *result)
+{
+    const int32_t *tree = t->layout;
+
+    FAST_LOWER_BOUND_BOUNDS(t, key, result);
+
+    __m512i v_key = _mm512_set1_epi32(key);
+    FAST_DESCEND(t, t->d_n, FAST_DK_AVX512,
+        __m512i v_tree = _mm512_loadu_si512((const void *)(tree + base_k));
+        unsigned mask = (unsigned)_mm512_cmpgt_epi32_mask(v_key, v_tree);
+        child_index = fast_mask_to_child(mask, b);
+    )
 
-            if (depth_remaining <= 0)
-                break;
+    (void)leaf_depth;
+    *result = (int64_t)path;
+}
+
+#endif /* FAST_HAVE_AVX_DISPATCH */
+#endif /* FAST_HAVE_SSE */
+
+/*
+ * AArch64 kernels.  NEON has no movemask; weighting the greater-than
+ * lanes by {1,2,4,8} and summing across the vector produces the same
+ * bitmask, which feeds FAST_LOOKUP exactly as the SSE kernel's does.
+ * The SVE kernels are length-agnostic: the same code serves 128- to
+ * 512-bit parts, with the block depth (t->d_k) sized from the runtime
+ * vector length at fast_create time and the per-block predicate
+ * limiting the compare to the 2^b - 1 keys actually in the block.
+ */
+#if FAST_HAVE_NEON
+
+void fast_search_neon(const struct fast_tree *t, int32_t key, int64_t *result)
+{
+    const int32_t *tree = t->layout;
+    static const uint32_t bits[4] = { 1, 2, 4, 8 };
+
+    FAST_SEARCH_BOUNDS(t, key, result);
+
+    int32x4_t v_key = vdupq_n_s32(key);
+    uint32x4_t v_bits = vld1q_u32(bits);
+    FAST_DESCEND(t, t->d_n, FAST_DK,
+        int32x4_t v_tree = vld1q_s32(tree + base_k);
+        uint32x4_t v_gt = vcgtq_s32(v_key, v_tree);
+        unsigned mask = vaddvq_u32(vandq_u32(v_gt, v_bits));
+        if (b > FAST_DK) {
+            uint32x4_t v_hi = vcgtq_s32(v_key,
+                                        vld1q_s32(tree + base_k + FAST_NK));
+            mask |= vaddvq_u32(vandq_u32(v_hi, v_bits)) << FAST_NK;
+            child_index = fast_mask_to_child(mask, b);
+        } else {
+            child_index = (b == FAST_DK) ? FAST_LOOKUP[mask & 0x7]
+                                         : (int)(mask & 0x1);
+        }
+    )
 
-            size_t child_subtree_size = ((size_t)1 << depth_remaining) - 1;
-            offset = offset + FAST_NK + (size_t)child_index * child_subtree_size;
+    *result = FAST_RESOLVE(t, key);
+}
 
+void fast_lower_bound_neon(const struct fast_tree *t, int32_t key,
+                           int64_t *result)
+{
+    const int32_t *tree = t->layout;
+    static const uint32_t bits[4] = { 1, 2, 4, 8 };
+
+    FAST_LOWER_BOUND_BOUNDS(t, key, result);
+
+    int32x4_t v_key = vdupq_n_s32(key);
+    uint32x4_t v_bits = vld1q_u32(bits);
+    FAST_DESCEND(t, t->d_n, FAST_DK,
+        int32x4_t v_tree = vld1q_s32(tree + base_k);
+        uint32x4_t v_gt = vcgtq_s32(v_key, v_tree);
+        unsigned mask = vaddvq_u32(vandq_u32(v_gt, v_bits));
+        if (b > FAST_DK) {
+            uint32x4_t v_hi = vcgtq_s32(v_key,
+                                        vld1q_s32(tree + base_k + FAST_NK));
+            mask |= vaddvq_u32(vandq_u32(v_hi, v_bits)) << FAST_NK;
+            child_index = fast_mask_to_child(mask, b);
+        } else {
+            child_index = (b == FAST_DK) ? FAST_LOOKUP[mask & 0x7]
+                                         : (int)(mask & 0x1);
+        }
+    )
+
+    (void)leaf_depth;
+    *result = (int64_t)path;
+}
+
+#if FAST_HAVE_SVE
+
+/* Bitmask of the active greater-than lanes: 1 << lane, summed. */
+static inline unsigned sve_gt_mask(svbool_t gt)
+{
+    svbool_t all = svptrue_b32();
+    svuint32_t v_bits = svlsl_u32_x(all, svdup_u32(1), svindex_u32(0, 1));
+    return (unsigned)svaddv_u32(all,
+        svmul_u32_x(all, svdup_u32_z(gt, 1), v_bits));
+}
+
+void fast_search_sve(const struct fast_tree *t, int32_t key, int64_t *result)
+{
+    const int32_t *tree = t->layout;
+
+    FAST_SEARCH_BOUNDS(t, key, result);
+
+    svint32_t v_key = svdup_s32(key);
+    FAST_DESCEND(t, t->d_n, t->d_k,
+        unsigned mask;
+        if (b > t->d_k) {
+            /* Folded terminal block: two half-block loads, the middle
+               node shared (and its mask bit computed) by both. */
+            unsigned half = (1u << (b - 1)) - 1;
+            svbool_t ph = svwhilelt_b32(0u, half + 1);
+            mask = sve_gt_mask(svcmpgt_s32(ph, v_key,
+                                           svld1_s32(ph, tree + base_k)));
+            mask |= sve_gt_mask(svcmpgt_s32(ph, v_key,
+                        svld1_s32(ph, tree + base_k + half))) << half;
+        } else {
+            svbool_t pg = svwhilelt_b32(0u, (1u << b) - 1);
+            svint32_t v_tree = svld1_s32(pg, tree + base_k);
+            mask = sve_gt_mask(svcmpgt_s32(pg, v_key, v_tree));
+        }
+        child_index = fast_mask_to_child(mask, b);
+    )
+
+    *result = FAST_RESOLVE(t, key);
+}
+
+void fast_lower_bound_sve(const struct fast_tree *t, int32_t key,
+                          int64_t *result)
+{
+    const int32_t *tree = t->layout;
+
+    FAST_LOWER_BOUND_BOUNDS(t, key, result);
+
+    svint32_t v_key = svdup_s32(key);
+    FAST_DESCEND(t, t->d_n, t->d_k,
+        unsigned mask;
+        if (b > t->d_k) {
+            /* Folded terminal block: two half-block loads, the middle
+               node shared (and its mask bit computed) by both. */
+            unsigned half = (1u << (b - 1)) - 1;
+            svbool_t ph = svwhilelt_b32(0u, half + 1);
+            mask = sve_gt_mask(svcmpgt_s32(ph, v_key,
+                                           svld1_s32(ph, tree + base_k)));
+            mask |= sve_gt_mask(svcmpgt_s32(ph, v_key,
+                        svld1_s32(ph, tree + base_k + half))) << half;
+        } else {
+            svbool_t pg = svwhilelt_b32(0u, (1u << b) - 1);
+            svint32_t v_tree = svld1_s32(pg, tree + base_k);
+            mask = sve_gt_mask(svcmpgt_s32(pg, v_key, v_tree));
+        }
+        child_index = fast_mask_to_child(mask, b);
+    )
+
+    (void)leaf_depth;
+    *result = (int64_t)path;
+}
+
+#endif /* FAST_HAVE_SVE */
+#endif /* FAST_HAVE_NEON */
+
+/*
+ * 64-bit key kernels.  The descent macros and the blocking arithmetic
+ * are key-width independent; only the block compare changes.  With
+ * 8-byte keys an SSE block holds a single key (d_K = 1), so the
+ * baseline kernel is the scalar node walk; AVX2 compares 3 keys and
+ * AVX-512 7 keys per block.  fast64 trees are always compact, so
+ * resolution is pure path arithmetic.
+ */
+static inline int64_t resolve_path64(const struct fast64_tree *t,
+                                     int64_t key, size_t path)
+{
+    const int64_t *keys = t->keys;
+    const size_t n = t->n;
+    int64_t lo = (int64_t)path - 1;
+
+    if (lo >= (int64_t)n) lo = (int64_t)n - 1;
+    for (int i = 0; i < 3 && lo + 1 < (int64_t)n; i++) {
+        if (keys[lo + 1] <= key) {
+            lo++;
+            FAST_STAT_ADD(t, FAST_ST_LEAF_SCANS, 1);
         } else {
-            child_index = (key > tree[offset]) ? 1 : 0;
-            depth_remaining -= 1;
-            last_block_type = 1;
             break;
         }
     }
+    return lo;
+}
 
-    if (last_block_type == 0)
-        *result = resolve_simd_leaf(t, key, offset, child_index);
-    else
-        *result = resolve_single_leaf(t, key, offset, child_index);
+#define FAST_RESOLVE64(t, key) \
+    ((void)leaf_depth, resolve_path64((t), (key), path))
+
+void fast64_search_scalar(const struct fast64_tree *t, int64_t key,
+                          int64_t *result)
+{
+    const int64_t *tree = t->layout;
+
+    FAST_SEARCH_BOUNDS(t, key, result);
+
+    FAST_DESCEND(t, t->d_n, t->d_k,
+        unsigned node = 0;
+        for (int i = 0; i < b; i++)
+            node = 2 * node + 1 + (key > tree[base_k + node] ? 1u : 0u);
+        child_index = (int)(node - (((unsigned)1 << b) - 1));
+    )
+
+    *result = FAST_RESOLVE64(t, key);
 }
+
+#if FAST_HAVE_AVX_DISPATCH
+
+__attribute__((target("avx2")))
+void fast64_search_avx2(const struct fast64_tree *t, int64_t key,
+                        int64_t *result)
+{
+    const int64_t *tree = t->layout;
+
+    FAST_SEARCH_BOUNDS(t, key, result);
+
+    __m256i v_key = _mm256_set1_epi64x(key);
+    FAST_DESCEND(t, t->d_n, FAST64_DK_AVX2,
+        __m256i v_tree = _mm256_loadu_si256((const __m256i *)(tree + base_k));
+        __m256i v_cmp = _mm256_cmpgt_epi64(v_key, v_tree);
+        unsigned mask = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(v_cmp));
+        if (b > FAST64_DK_AVX2) {
+            /* Folded 7-key terminal block (a full d_L = 3 cache line
+               block): second load covers the bottom row. */
+            __m256i v_hi = _mm256_loadu_si256(
+                (const __m256i *)(tree + base_k + 3));
+            mask |= (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(
+                _mm256_cmpgt_epi64(v_key, v_hi))) << 3;
+        }
+        child_index = fast_mask_to_child(mask, b);
+    )
+
+    *result = FAST_RESOLVE64(t, key);
+}
+
+__attribute__((target("avx512f")))
+void fast64_search_avx512(const struct fast64_tree *t, int64_t key,
+                          int64_t *result)
+{
+    const int64_t *tree = t->layout;
+
+    FAST_SEARCH_BOUNDS(t, key, result);
+
+    __m512i v_key = _mm512_set1_epi64(key);
+    FAST_DESCEND(t, t->d_n, FAST64_DK_AVX512,
+        __m512i v_tree = _mm512_loadu_si512((const void *)(tree + base_k));
+        unsigned mask = (unsigned)_mm512_cmpgt_epi64_mask(v_key, v_tree);
+        child_index = fast_mask_to_child(mask, b);
+    )
+
+    *result = FAST_RESOLVE64(t, key);
+}
+
+#endif /* FAST_HAVE_AVX_DISPATCH */
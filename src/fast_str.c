@@ -0,0 +1,220 @@
+/*
+ * Byte-string keys via order-preserving prefix encoding.
+ *
+ * Arbitrary-length keys do not fit the fixed-lane SIMD blocks, but
+ * their first 8 bytes, taken big-endian, compare as integers in the
+ * same order as the strings compare with memcmp.  So the index is a
+ * fast64 tree over those prefixes — string probes get the same blocked
+ * SIMD descent as integer keys — plus a compact tail pool holding only
+ * the bytes each key has beyond its prefix.
+ *
+ * A probe descends twice: one lower-bound each for the first and the
+ * last key sharing the query's prefix.  When the run
+ * between them is empty the prefix alone decides the answer; otherwise
+ * a binary search over the run's tails settles the tie.  Keys that
+ * share a long common prefix (URLs behind "https://", UUID blocks) all
+ * collapse into one run, so the tail search — not a degenerate tree —
+ * absorbs the skew.
+ */
+
+#include "fast_internal.h"
+
+/* Flips unsigned big-endian order into int64 order. */
+#define FAST_STR_SIGN 0x8000000000000000ULL
+
+struct fast_str_tree {
+    struct fast64_tree *tree;  /* order-preserving 8-byte prefixes */
+    uint8_t  *tails;           /* concatenated bytes beyond the prefixes */
+    size_t   *tail_off;        /* n + 1 offsets into tails */
+    uint8_t  *head_len;        /* bytes of key i covered by its prefix (<= 8) */
+    size_t    n;
+};
+
+static int64_t str_prefix(const uint8_t *s, size_t len)
+{
+    uint64_t p = 0;
+    size_t m = (len < 8) ? len : 8;
+
+    for (size_t i = 0; i < m; i++)
+        p |= (uint64_t)s[i] << (56 - 8 * i);
+    return (int64_t)(p ^ FAST_STR_SIGN);
+}
+
+/*
+ * memcmp order of stored key `index` against the query: negative when
+ * the stored key sorts first.  The head bytes are rematerialized from
+ * the prefix integer, so the pool never duplicates them.
+ */
+static int str_cmp_at(const struct fast_str_tree *t, size_t index,
+                      const uint8_t *q, size_t qlen)
+{
+    uint8_t head[8];
+    uint64_t p = (uint64_t)fast64_key_at(t->tree, index) ^ FAST_STR_SIGN;
+    size_t hlen = t->head_len[index];
+    size_t tlen = t->tail_off[index + 1] - t->tail_off[index];
+    size_t klen = hlen + tlen;
+    size_t m = (klen < qlen) ? klen : qlen;
+    int c;
+
+    for (size_t i = 0; i < hlen; i++)
+        head[i] = (uint8_t)(p >> (56 - 8 * i));
+
+    c = memcmp(head, q, (m < hlen) ? m : hlen);
+    if (c == 0 && m > hlen)
+        c = memcmp(t->tails + t->tail_off[index], q + hlen, m - hlen);
+    if (c != 0)
+        return c;
+    return (klen > qlen) - (klen < qlen);
+}
+
+fast_str_tree_t *fast_str_create(const void *const *keys, const size_t *lens,
+                                 size_t n)
+{
+    if (!keys || !lens || n == 0)
+        return NULL;
+
+    struct fast_str_tree *t =
+        (struct fast_str_tree *)calloc(1, sizeof(struct fast_str_tree));
+    int64_t *pfx = (int64_t *)malloc(n * sizeof(int64_t));
+    size_t tail_total = 0;
+
+    for (size_t i = 0; i < n; i++)
+        tail_total += (lens[i] > 8) ? lens[i] - 8 : 0;
+
+    if (t) {
+        t->tails = (uint8_t *)malloc(tail_total ? tail_total : 1);
+        t->tail_off = (size_t *)malloc((n + 1) * sizeof(size_t));
+        t->head_len = (uint8_t *)malloc(n);
+    }
+    if (!t || !pfx || !t->tails || !t->tail_off || !t->head_len)
+        goto fail;
+
+    t->n = n;
+    t->tail_off[0] = 0;
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t *s = (const uint8_t *)keys[i];
+        size_t tail = (lens[i] > 8) ? lens[i] - 8 : 0;
+
+        pfx[i] = str_prefix(s, lens[i]);
+        t->head_len[i] = (uint8_t)(lens[i] - tail);
+        if (tail)
+            memcpy(t->tails + t->tail_off[i], s + 8, tail);
+        t->tail_off[i + 1] = t->tail_off[i] + tail;
+    }
+
+    t->tree = fast64_create(pfx, n);
+    if (!t->tree)
+        goto fail;
+    free(pfx);
+    return t;
+
+fail:
+    free(pfx);
+    fast_str_destroy(t);
+    return NULL;
+}
+
+void fast_str_destroy(fast_str_tree_t *tree)
+{
+    if (!tree)
+        return;
+    fast64_destroy(tree->tree);
+    free(tree->tails);
+    free(tree->tail_off);
+    free(tree->head_len);
+    free(tree);
+}
+
+/*
+ * Locate the run of keys sharing the query's prefix: [*lb, *ub]
+ * inclusive, with *lb > *ub when no key has the prefix.  Two
+ * lower-bound descents through the SIMD kernels — at qp and qp + 1 —
+ * because lower-bound ranks come straight from the descent path and
+ * stay exact over arbitrarily long duplicate runs, which the
+ * predecessor search's capped fixup scan does not.
+ */
+static void str_prefix_run(const struct fast_str_tree *t, int64_t qp,
+                           int64_t *lb, int64_t *ub)
+{
+    *lb = fast64_search_lower_bound(t->tree, qp);
+    *ub = (qp == INT64_MAX)
+        ? (int64_t)t->n - 1
+        : fast64_search_lower_bound(t->tree, qp + 1) - 1;
+}
+
+int64_t fast_str_search(const fast_str_tree_t *tree, const void *key,
+                        size_t len)
+{
+    if (!tree || (!key && len > 0))
+        return -1;
+
+    const uint8_t *q = (const uint8_t *)key;
+    int64_t lb, ub;
+
+    str_prefix_run(tree, str_prefix(q, len), &lb, &ub);
+    if (lb > ub)
+        return lb - 1;   /* keys below lb have smaller prefixes, so
+                            they sort entirely below the query */
+
+    /* Last key in the run at or below the query; landing on lb - 1
+       means the whole run's tails sort above it. */
+    int64_t lo = lb - 1, hi = ub;
+    while (lo < hi) {
+        int64_t mid = hi - (hi - lo) / 2;
+        if (str_cmp_at(tree, (size_t)mid, q, len) <= 0)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    return lo;
+}
+
+int64_t fast_str_lower_bound(const fast_str_tree_t *tree, const void *key,
+                             size_t len)
+{
+    if (!tree || (!key && len > 0))
+        return -1;
+
+    const uint8_t *q = (const uint8_t *)key;
+    int64_t lb, ub;
+
+    str_prefix_run(tree, str_prefix(q, len), &lb, &ub);
+    if (lb > ub)
+        return lb;
+
+    /* Last key in the run strictly below the query, plus one. */
+    int64_t lo = lb - 1, hi = ub;
+    while (lo < hi) {
+        int64_t mid = hi - (hi - lo) / 2;
+        if (str_cmp_at(tree, (size_t)mid, q, len) < 0)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    return lo + 1;
+}
+
+size_t fast_str_size(const fast_str_tree_t *tree)
+{
+    return tree ? tree->n : 0;
+}
+
+size_t fast_str_key_at(const fast_str_tree_t *tree, size_t index,
+                       void *out, size_t max)
+{
+    if (!tree || index >= tree->n)
+        return 0;
+
+    uint64_t p = (uint64_t)fast64_key_at(tree->tree, index) ^ FAST_STR_SIGN;
+    size_t hlen = tree->head_len[index];
+    size_t tlen = tree->tail_off[index + 1] - tree->tail_off[index];
+    uint8_t *o = (uint8_t *)out;
+
+    for (size_t i = 0; i < hlen && i < max; i++)
+        o[i] = (uint8_t)(p >> (56 - 8 * i));
+    if (max > hlen) {
+        size_t c = (tlen < max - hlen) ? tlen : max - hlen;
+        memcpy(o + hlen, tree->tails + tree->tail_off[index], c);
+    }
+    return hlen + tlen;
+}
@@ -0,0 +1,157 @@
+/*
+ * Query-hotness-aware residency pinning (fast_create_tiered).
+ *
+ * Skewed workloads concentrate most probes in a few page-block
+ * subtrees, but the layout treats all blocks uniformly, so cold blocks
+ * compete with hot ones for residency and the tail latency is set by
+ * cold DRAM fetches.  This mode takes a sample of the expected query
+ * distribution, counts how often each child subtree of the top page
+ * block is hit, and pins the hot tier: the top block plus the hottest
+ * subtrees (and the key/rank spans their leaf resolution touches) are
+ * mlocked, prefaulted and marked MADV_HUGEPAGE, while the cold
+ * remainder is hinted MADV_COLD.
+ *
+ * Every page-block subtree occupies a contiguous layout range (the
+ * uniform offset rule), and its leaves map to one contiguous rank
+ * window, so the hot tier is a handful of range operations — the tree
+ * itself, and therefore every search path, is unchanged.  All hints
+ * are best effort: mlock may be refused by RLIMIT_MEMLOCK and the
+ * madvise calls may be unsupported, and the tree works identically
+ * without them.  Hardware cache partitioning (e.g. CAT) is outside
+ * what a library can portably do; residency pinning removes the page
+ * faults and reclaim-induced DRAM refills that dominate p99.
+ */
+
+#include "fast_internal.h"
+
+#include <sys/mman.h>
+
+/* Fraction of the sampled probes the pinned tier aims to cover. */
+#define FAST_HOT_COVER_NUM 9
+#define FAST_HOT_COVER_DEN 10
+
+/* Round [p, p+bytes) out to page boundaries and pin it resident. */
+static void pin_range(const struct fast_tree *t, const void *p, size_t bytes)
+{
+    uintptr_t lo = (uintptr_t)p & ~(uintptr_t)(t->page_size - 1);
+    uintptr_t hi = ((uintptr_t)p + bytes + t->page_size - 1) &
+                   ~(uintptr_t)(t->page_size - 1);
+#ifdef MADV_WILLNEED
+    madvise((void *)lo, hi - lo, MADV_WILLNEED);
+#endif
+#ifdef MADV_HUGEPAGE
+    madvise((void *)lo, hi - lo, MADV_HUGEPAGE);
+#endif
+    mlock((void *)lo, hi - lo);
+
+    /* Prefault so the first hot-path probe does not take the fault.
+       Touch only [p, p+bytes): the rounded range may extend past the
+       allocation, and mlock has already faulted in the full pages. */
+    volatile const char *c = (volatile const char *)p;
+    for (size_t off = 0; off < bytes; off += t->page_size)
+        (void)c[off];
+    if (bytes > 0)
+        (void)c[bytes - 1];
+}
+
+static void cool_range(const struct fast_tree *t, const void *p, size_t bytes)
+{
+#ifdef MADV_COLD
+    uintptr_t lo = ((uintptr_t)p + t->page_size - 1) &
+                   ~(uintptr_t)(t->page_size - 1);
+    uintptr_t hi = ((uintptr_t)p + bytes) & ~(uintptr_t)(t->page_size - 1);
+    if (hi > lo)
+        madvise((void *)lo, hi - lo, MADV_COLD);
+#else
+    (void)t;
+    (void)p;
+    (void)bytes;
+#endif
+}
+
+fast_tree_t *fast_create_tiered(const int32_t *keys, size_t n,
+                                const int32_t *sample, size_t sample_n)
+{
+    fast_tree_t *t = fast_create(keys, n);
+    if (!t)
+        return NULL;
+    if (!sample || sample_n == 0)
+        return t;   /* no distribution to learn from; plain tree */
+
+    int t_p = (t->d_n < t->d_p) ? t->d_n : t->d_p;
+    int rem = t->d_n - t_p;
+    size_t top_nodes = (((size_t)1) << t_p) - 1;
+
+    if (rem == 0) {
+        /* The whole tree is one page block: pin it all. */
+        pin_range(t, t->layout, t->tree_nodes * sizeof(int32_t));
+        pin_range(t, t->keys, n * sizeof(int32_t));
+        if (t->sorted_rank)
+            pin_range(t, t->sorted_rank, t->layout_size * sizeof(int32_t));
+        t->hot_pinned = 1;
+        return t;
+    }
+
+    /* Hit count per child subtree of the top page block.  A query's
+       child index is the top t_p bits of its lower-bound rank: each
+       subtree covers one aligned 2^rem-wide rank window. */
+    size_t nchildren = ((size_t)1) << t_p;
+    size_t *hits = (size_t *)calloc(nchildren, sizeof(size_t));
+    if (!hits)
+        return t;   /* tree is fine, just unpinned */
+
+    for (size_t i = 0; i < sample_n; i++) {
+        int64_t r = fast_search_lower_bound(t, sample[i]);
+        if (r >= (int64_t)n)
+            r = (int64_t)n - 1;
+        hits[(size_t)r >> rem]++;
+    }
+
+    /* Pin the top block, then the hottest children until the tier
+       covers its share of the sample; hint the rest cold. */
+    pin_range(t, t->layout, top_nodes * sizeof(int32_t));
+
+    size_t child_size = (((size_t)1) << rem) - 1;
+    size_t covered = 0;
+    size_t goal = sample_n * FAST_HOT_COVER_NUM / FAST_HOT_COVER_DEN;
+
+    while (covered < goal) {
+        size_t best = nchildren;
+        for (size_t c = 0; c < nchildren; c++) {
+            if (hits[c] != SIZE_MAX &&
+                (best == nchildren || hits[c] > hits[best]))
+                best = c;
+        }
+        if (best == nchildren || hits[best] == 0)
+            break;
+
+        size_t base = top_nodes + best * child_size;
+        pin_range(t, t->layout + base, child_size * sizeof(int32_t));
+        if (t->sorted_rank)
+            pin_range(t, t->sorted_rank + base,
+                      child_size * sizeof(int32_t));
+
+        /* Leaf resolution touches this subtree's rank window of the
+           key array. */
+        size_t k_lo = best << rem;
+        size_t k_hi = (best + 1) << rem;
+        if (k_lo < n) {
+            if (k_hi > n)
+                k_hi = n;
+            pin_range(t, t->keys + k_lo, (k_hi - k_lo) * sizeof(int32_t));
+        }
+
+        covered += hits[best];
+        hits[best] = SIZE_MAX;   /* marks the child as pinned */
+    }
+
+    for (size_t c = 0; c < nchildren; c++) {
+        if (hits[c] != SIZE_MAX)
+            cool_range(t, t->layout + top_nodes + c * child_size,
+                       child_size * sizeof(int32_t));
+    }
+
+    free(hits);
+    t->hot_pinned = 1;
+    return t;
+}
@@ -0,0 +1,238 @@
+/*
+ * Incremental updates: fast_insert and fast_merge.
+ *
+ * The tree layout is immutable by design (its value is the blocked,
+ * branch-free probe path), so inserts land in a small sorted side
+ * buffer instead of the layout.  Every read-path entry point combines
+ * the buffer with the main tree by rank arithmetic: the merged index of
+ * a result is its main-tree index plus the number of buffered keys at
+ * or below the query, so callers see one logically sorted key sequence
+ * and never pay more than one extra binary search over the buffer.
+ *
+ * fast_merge folds the buffer back in: it two-way merges the key
+ * arrays, rebuilds the layout with the tree's original build settings
+ * (including the parallel builder and compressed transcoding), and
+ * swaps the new arrays in place.  Reads between merges stay at full
+ * tree speed; writes never trigger an implicit rebuild.
+ */
+
+#include "fast_internal.h"
+
+#include <sys/mman.h>
+
+/* Number of buffered keys <= key (and < key, for lower bounds). */
+size_t fast_delta_count_le(const struct fast_tree *t, int32_t key)
+{
+    size_t lo = 0, hi = t->delta_n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (t->delta[mid] <= key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+size_t fast_delta_count_lt(const struct fast_tree *t, int32_t key)
+{
+    size_t lo = 0, hi = t->delta_n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (t->delta[mid] < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/*
+ * Select the index-th smallest key of the merged sequence without
+ * materializing it: binary search for the split point j such that j
+ * buffered keys and index+1-j main keys precede it.
+ */
+int32_t fast_merged_key_at(const struct fast_tree *t, size_t index)
+{
+    const int32_t *keys = t->keys;
+    const int32_t *delta = t->delta;
+    size_t take = index + 1;
+    size_t lo = (take > t->n) ? take - t->n : 0;
+    size_t hi = (take < t->delta_n) ? take : t->delta_n;
+
+    for (;;) {
+        size_t j = lo + (hi - lo) / 2;   /* keys taken from the buffer */
+        size_t a = take - j;             /* keys taken from the tree */
+
+        if (a > 0 && j < t->delta_n && delta[j] < keys[a - 1]) {
+            lo = j + 1;                  /* buffer owes more keys */
+        } else if (j > 0 && a < t->n && delta[j - 1] > keys[a]) {
+            hi = j - 1;                  /* buffer gave too many */
+        } else {
+            if (a == 0)
+                return delta[j - 1];
+            if (j == 0)
+                return keys[a - 1];
+            return (keys[a - 1] > delta[j - 1]) ? keys[a - 1] : delta[j - 1];
+        }
+    }
+}
+
+/* Two-way merge copy of [lo, hi] from the tree keys and the buffer. */
+size_t fast_merged_range_copy(const struct fast_tree *t, int32_t lo,
+                              int32_t hi, int32_t *out, size_t max)
+{
+    /* First candidate on each side. */
+    size_t a = 0, an = t->n;
+    {
+        size_t l = 0, h = an;
+        while (l < h) {
+            size_t mid = l + (h - l) / 2;
+            if (t->keys[mid] < lo)
+                l = mid + 1;
+            else
+                h = mid;
+        }
+        a = l;
+    }
+    size_t b = fast_delta_count_lt(t, lo);
+
+    size_t copied = 0;
+    while (copied < max) {
+        int have_a = (a < an && t->keys[a] <= hi);
+        int have_b = (b < t->delta_n && t->delta[b] <= hi);
+        if (!have_a && !have_b)
+            break;
+        if (have_a && (!have_b || t->keys[a] <= t->delta[b]))
+            out[copied++] = t->keys[a++];
+        else
+            out[copied++] = t->delta[b++];
+    }
+    return copied;
+}
+
+int fast_insert(fast_tree_t *tree, int32_t key)
+{
+    if (!tree)
+        return -1;
+    /* Mapped trees do not own their arrays, replicated trees would
+       need every replica's buffer kept in step, arena trees are
+       reclaimed wholesale, a key-only insert would desync a kv tree's
+       value array, and merging a tiered tree would free its mlocked
+       arrays (and lose the learned pinning); all of these stay
+       build-once. */
+    if (tree->from_file || tree->numa_replicated || tree->arena ||
+        tree->values || tree->hot_pinned)
+        return -1;
+
+    if (tree->delta_n == tree->delta_cap) {
+        size_t cap = tree->delta_cap ? tree->delta_cap * 2 : 256;
+        int32_t *buf = (int32_t *)realloc(tree->delta, cap * sizeof(int32_t));
+        if (!buf)
+            return -1;
+        tree->delta = buf;
+        tree->delta_cap = cap;
+    }
+
+    /* Keep the buffer sorted: it is small between merges, so the
+       memmove is cheap and every search stays a binary search. */
+    size_t pos = fast_delta_count_le(tree, key);
+    memmove(tree->delta + pos + 1, tree->delta + pos,
+            (tree->delta_n - pos) * sizeof(int32_t));
+    tree->delta[pos] = key;
+    tree->delta_n++;
+    return 0;
+}
+
+int fast_merge(fast_tree_t *tree)
+{
+    if (!tree)
+        return -1;
+    if (tree->delta_n == 0)
+        return 0;
+    if (tree->from_file || tree->numa_replicated || tree->arena ||
+        tree->values || tree->hot_pinned)
+        return -1;
+
+    size_t n = tree->n + tree->delta_n;
+    int32_t *merged = (int32_t *)malloc(n * sizeof(int32_t));
+    if (!merged)
+        return -1;
+
+    size_t a = 0, b = 0, w = 0;
+    while (a < tree->n && b < tree->delta_n)
+        merged[w++] = (tree->keys[a] <= tree->delta[b]) ? tree->keys[a++]
+                                                        : tree->delta[b++];
+    while (a < tree->n)
+        merged[w++] = tree->keys[a++];
+    while (b < tree->delta_n)
+        merged[w++] = tree->delta[b++];
+
+    /* Rebuild into a scratch tree with the original build settings, so
+       a failed build leaves the live tree (and its buffer) untouched. */
+    struct fast_tree nt;
+    memset(&nt, 0, sizeof(nt));
+    nt.want_huge = tree->want_huge;
+    nt.build_threads = tree->build_threads;
+    nt.compact = tree->compact;
+    nt.compressed = tree->compressed;
+    nt.force_scalar = tree->force_scalar;
+    nt.prefetch = tree->prefetch;
+    nt.d_k = tree->d_k;
+    nt.n_k = tree->n_k;
+    nt.d_l = tree->d_l;
+    if (tree->compressed)
+        nt.d_p = tree->d_p;   /* transcoder depths are preset */
+
+    if (fast_build_layout(&nt, merged, n) != 0) {
+        free(merged);
+        return -1;
+    }
+    if (nt.compressed && fast_compress_layout(&nt) != 0) {
+        if (nt.layout_map)
+            munmap(nt.layout_map, nt.layout_map_bytes);
+        else
+            free(nt.layout);
+        free(nt.sorted_rank);
+        free(nt.keys);
+        free(merged);
+        return -1;
+    }
+    free(merged);
+
+    /* Swap the rebuilt arrays in and drop the folded buffer. */
+    if (tree->layout_map)
+        munmap(tree->layout_map, tree->layout_map_bytes);
+    else
+        free(tree->layout);
+    free(tree->comp_deltas);
+    free(tree->comp_dir);
+    free(tree->comp_raw);
+    free(tree->sorted_rank);
+    free(tree->keys);
+    free(tree->delta);
+    tree->delta = NULL;
+    tree->delta_n = 0;
+    tree->delta_cap = 0;
+
+    tree->layout = nt.layout;
+    tree->layout_map = nt.layout_map;
+    tree->layout_map_bytes = nt.layout_map_bytes;
+    tree->sorted_rank = nt.sorted_rank;
+    tree->keys = nt.keys;
+    tree->n = nt.n;
+    tree->layout_size = nt.layout_size;
+    tree->tree_nodes = nt.tree_nodes;
+    tree->d_n = nt.d_n;
+    tree->d_p = nt.d_p;
+    tree->n_p = nt.n_p;
+    tree->d_p2 = nt.d_p2;
+    tree->page_size = nt.page_size;
+    tree->comp_deltas = nt.comp_deltas;
+    tree->comp_dir = nt.comp_dir;
+    tree->comp_raw = nt.comp_raw;
+    tree->comp_raw_size = nt.comp_raw_size;
+    memcpy(tree->comp_round_off, nt.comp_round_off,
+           sizeof(tree->comp_round_off));
+    return 0;
+}
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 #include "fast.h"
 
 static int tests_run = 0;
@@ -182,6 +183,234 @@ static void test_lower_bound(void)
     if (fast_search_lower_bound(t, 100) == 5) PASS(); else FAIL("expected 5");
 
     fast_destroy(t);
+
+    TEST("lower_bound: descent kernels agree with binary search");
+    const size_t N = 30000;
+    int32_t *big = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(big);
+    big[0] = -40000;
+    for (size_t i = 1; i < N; i++)
+        big[i] = big[i - 1] + (int32_t)(i % 13 == 0 ? 0 : 3);  /* dups too */
+
+    static const char *widths[] = {"sse", "avx2", "avx512"};
+    int ok = 1;
+    for (size_t w = 0; w < 3 && ok; w++) {
+        setenv("FAST_SIMD", widths[w], 1);
+        fast_tree_t *tw = fast_create(big, N);
+        unsetenv("FAST_SIMD");
+        assert(tw);
+        for (int trial = 0; trial < 3000 && ok; trial++) {
+            int32_t q = (int32_t)(rand() % 140000) - 50000;
+            int64_t lb = fast_search_lower_bound(tw, q);
+            /* Reference: first index with big[i] >= q. */
+            size_t lo = 0, hi = N;
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (big[mid] < q)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            if (lb != (int64_t)lo) ok = 0;
+        }
+        fast_destroy(tw);
+    }
+    if (ok) PASS(); else FAIL("kernel/binary-search mismatch");
+
+    TEST("lower_bound: batch agrees with single-key calls");
+    fast_tree_t *tb = fast_create(big, N);
+    assert(tb);
+    int32_t lbq[300];
+    int64_t lbr[300];
+    for (int i = 0; i < 300; i++)
+        lbq[i] = (int32_t)(rand() % 140000) - 50000;
+    fast_search_lower_bound_batch(tb, lbq, 300, lbr);
+    ok = 1;
+    for (int i = 0; i < 300; i++) {
+        if (lbr[i] != fast_search_lower_bound(tb, lbq[i])) { ok = 0; break; }
+    }
+    if (ok) PASS(); else FAIL("batch/single mismatch");
+    fast_destroy(tb);
+    free(big);
+}
+
+static void test_range_scan(void)
+{
+    int32_t keys[] = {10, 20, 30, 40, 50, 60, 70, 80};
+    fast_tree_t *t = fast_create(keys, 8);
+    assert(t != NULL);
+
+    TEST("range count: interior range");
+    if (fast_range_count(t, 25, 55) == 3) PASS(); else FAIL("expected 3");
+
+    TEST("range count: exact endpoints");
+    if (fast_range_count(t, 20, 60) == 5) PASS(); else FAIL("expected 5");
+
+    TEST("range count: empty range");
+    if (fast_range_count(t, 31, 39) == 0 &&
+        fast_range_count(t, 90, 100) == 0 &&
+        fast_range_count(t, 55, 25) == 0) PASS();
+    else FAIL("expected 0");
+
+    TEST("range count: full range");
+    if (fast_range_count(t, 0, 100) == 8) PASS(); else FAIL("expected 8");
+
+    TEST("range copy: values and truncation");
+    int32_t out[8];
+    size_t got = fast_range_copy(t, 25, 75, out, 8);
+    int ok = (got == 5 && out[0] == 30 && out[4] == 70);
+    got = fast_range_copy(t, 25, 75, out, 2);
+    ok = ok && (got == 2 && out[0] == 30 && out[1] == 40);
+    if (ok) PASS(); else FAIL("bad copy");
+
+    TEST("keys ptr: zero-copy accessor");
+    const int32_t *p = fast_keys_ptr(t);
+    if (p && p[0] == 10 && p[7] == 80) PASS(); else FAIL("bad pointer");
+
+    fast_destroy(t);
+}
+
+static void test_huge_pages(void)
+{
+    /* Large enough (> 2MB of layout) that the superpage blocking level
+       engages; exercises the 4-level nested offset arithmetic. */
+    TEST("hugepage mode: 600K keys, superpage blocking");
+    const size_t N = 600000;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(keys);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 3 + 1);
+
+    fast_tree_t *t = fast_create_huge(keys, N);
+    assert(t != NULL);
+    int ok = 1;
+    for (size_t i = 0; i < N; i += 7) {
+        if (fast_search(t, keys[i]) != (int64_t)i) { ok = 0; break; }
+        if (fast_search(t, keys[i] + 1) != (int64_t)i) { ok = 0; break; }
+    }
+    if (ok) PASS(); else FAIL("mismatch");
+
+    TEST("hugepage mode: batch search agrees");
+    int32_t queries[128];
+    int64_t results[128];
+    for (int i = 0; i < 128; i++) queries[i] = (int32_t)(i * 9901 + 5);
+    fast_search_batch(t, queries, 128, results);
+    ok = 1;
+    for (int i = 0; i < 128; i++) {
+        if (results[i] != fast_search(t, queries[i])) { ok = 0; break; }
+    }
+    if (ok) PASS(); else FAIL("batch/single mismatch");
+
+    fast_destroy(t);
+    free(keys);
+}
+
+static void test_simd_widths(void)
+{
+    /* Exercise every kernel the hardware supports by forcing the width
+       down via FAST_SIMD.  Each width implies a different blocked
+       layout, so verify searches (single and batch) for each. */
+    static const char *widths[] = {"sse", "avx2", "avx512"};
+    const size_t N = 6000;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    int64_t results[64];
+    int32_t queries[64];
+    assert(keys);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 5 + 2);
+    for (int i = 0; i < 64; i++) queries[i] = (int32_t)(i * 397 + 1);
+
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+        char name[64];
+        snprintf(name, sizeof(name), "SIMD width %s: search + batch", widths[w]);
+        TEST(name);
+
+        setenv("FAST_SIMD", widths[w], 1);
+        fast_tree_t *t = fast_create(keys, N);
+        unsetenv("FAST_SIMD");
+        assert(t != NULL);
+
+        int ok = 1;
+        for (size_t i = 0; i < N && ok; i++) {
+            if (fast_search(t, keys[i]) != (int64_t)i) ok = 0;
+            if (fast_search(t, keys[i] + 1) != (int64_t)i) ok = 0;
+            if (i > 0 && fast_search(t, keys[i] - 1) != (int64_t)i - 1) ok = 0;
+        }
+        fast_search_batch(t, queries, 64, results);
+        for (int i = 0; i < 64 && ok; i++) {
+            if (results[i] != fast_search(t, queries[i])) ok = 0;
+        }
+        if (ok) PASS(); else FAIL("mismatch");
+
+        fast_destroy(t);
+    }
+    free(keys);
+}
+
+static void test_batch_search(void)
+{
+    TEST("batch search: agrees with fast_search");
+    const size_t N = 5000, M = 2000;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    int32_t *queries = (int32_t *)malloc(M * sizeof(int32_t));
+    int64_t *results = (int64_t *)malloc(M * sizeof(int64_t));
+    assert(keys && queries && results);
+
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 7 + 3);
+    srand(777);
+    for (size_t i = 0; i < M; i++)
+        queries[i] = (int32_t)(rand() % (int)(N * 8));
+
+    fast_tree_t *t = fast_create(keys, N);
+    assert(t != NULL);
+
+    fast_search_batch(t, queries, M, results);
+    int ok = 1;
+    for (size_t i = 0; i < M; i++) {
+        if (results[i] != fast_search(t, queries[i])) { ok = 0; break; }
+    }
+    if (ok) PASS(); else FAIL("batch/single mismatch");
+
+    TEST("batch search: partial batch (m < pipeline width)");
+    fast_search_batch(t, queries, 3, results);
+    ok = 1;
+    for (size_t i = 0; i < 3; i++) {
+        if (results[i] != fast_search(t, queries[i])) { ok = 0; break; }
+    }
+    if (ok) PASS(); else FAIL("batch/single mismatch");
+
+    fast_destroy(t);
+    free(keys);
+    free(queries);
+    free(results);
+}
+
+static void test_page_block_boundary(void)
+{
+    /* Sizes straddling the 4KB page-block depth (d_p=10, 1023 keys) so
+       the descent crosses a page-block boundary. */
+    static const size_t sizes[] = {1023, 1024, 1025, 2047, 2048, 4100};
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t n = sizes[s];
+        char name[64];
+        snprintf(name, sizeof(name), "%zu elements: page-block boundary", n);
+        TEST(name);
+
+        int32_t *keys = (int32_t *)malloc(n * sizeof(int32_t));
+        assert(keys);
+        for (size_t i = 0; i < n; i++) keys[i] = (int32_t)(i * 3 + 1);
+
+        fast_tree_t *t = fast_create(keys, n);
+        assert(t != NULL);
+        int ok = 1;
+        for (size_t i = 0; i < n; i++) {
+            if (fast_search(t, keys[i]) != (int64_t)i) { ok = 0; break; }
+            if (fast_search(t, keys[i] + 1) != (int64_t)i) { ok = 0; break; }
+        }
+        if (ok) PASS(); else FAIL("mismatch");
+
+        fast_destroy(t);
+        free(keys);
+    }
 }
 
 static int cmp_int32(const void *a, const void *b)
@@ -190,6 +419,575 @@ static int cmp_int32(const void *a, const void *b)
     return (x > y) - (x < y);
 }
 
+static void test_save_open(void)
+{
+    const char *path = "/tmp/fast_test_tree.img";
+    const size_t N = 20000;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(keys);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 11 + 4);
+
+    TEST("save/open: round trip preserves searches");
+    fast_tree_t *t = fast_create(keys, N);
+    assert(t != NULL);
+    int ok = (fast_save(t, path) == 0);
+
+    fast_tree_t *m = ok ? fast_open_mmap(path) : NULL;
+    if (m) {
+        if (fast_size(m) != N) ok = 0;
+        for (size_t i = 0; i < N && ok; i += 3) {
+            if (fast_search(m, keys[i]) != (int64_t)i) ok = 0;
+            if (fast_search(m, keys[i] + 1) != (int64_t)i) ok = 0;
+        }
+        if (fast_search_lower_bound(m, keys[7]) != 7) ok = 0;
+        fast_destroy(m);
+    } else {
+        ok = 0;
+    }
+    if (ok) PASS(); else FAIL("round trip failed");
+
+    TEST("save/open: rejects truncated image");
+    FILE *f = fopen(path, "wb");
+    assert(f);
+    fwrite("FASTJUNK", 1, 8, f);
+    fclose(f);
+    if (fast_open_mmap(path) == NULL) PASS(); else FAIL("accepted junk");
+
+    remove(path);
+    fast_destroy(t);
+    free(keys);
+}
+
+static void test_parallel_build(void)
+{
+    TEST("parallel build: identical results to serial");
+    const size_t N = 300000;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(keys);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 2 + 1);
+
+    fast_tree_t *ts = fast_create(keys, N);
+    fast_tree_t *tp = fast_create_parallel(keys, N, 4);
+    assert(ts && tp);
+
+    int ok = 1;
+    for (size_t i = 0; i < N; i += 13) {
+        if (fast_search(tp, keys[i]) != fast_search(ts, keys[i])) { ok = 0; break; }
+        if (fast_search(tp, keys[i] + 1) != fast_search(ts, keys[i] + 1)) { ok = 0; break; }
+    }
+    if (ok) PASS(); else FAIL("parallel/serial mismatch");
+
+    TEST("parallel build: small tree (serial fallback)");
+    fast_tree_t *tsmall = fast_create_parallel(keys, 100, 8);
+    assert(tsmall);
+    ok = 1;
+    for (size_t i = 0; i < 100; i++) {
+        if (fast_search(tsmall, keys[i]) != (int64_t)i) { ok = 0; break; }
+    }
+    if (ok) PASS(); else FAIL("mismatch");
+
+    fast_destroy(tsmall);
+    fast_destroy(tp);
+    fast_destroy(ts);
+    free(keys);
+}
+
+static void test_compact(void)
+{
+    TEST("compact: identical results to rank-table tree");
+    const size_t N = 50000;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(keys);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 7 + 3);
+
+    fast_tree_t *tr = fast_create(keys, N);
+    fast_tree_t *tc = fast_create_compact(keys, N);
+    assert(tr && tc);
+
+    int ok = 1;
+    for (size_t i = 0; i < N; i += 11) {
+        if (fast_search(tc, keys[i]) != fast_search(tr, keys[i])) { ok = 0; break; }
+        if (fast_search(tc, keys[i] + 1) != fast_search(tr, keys[i] + 1)) { ok = 0; break; }
+        if (fast_search(tc, keys[i] - 1) != fast_search(tr, keys[i] - 1)) { ok = 0; break; }
+    }
+    if (ok) PASS(); else FAIL("compact/rank mismatch");
+
+    TEST("compact: batch search agreement");
+    int32_t queries[64];
+    int64_t rc_res[64], rr_res[64];
+    for (int i = 0; i < 64; i++) queries[i] = (int32_t)(i * 997 + 1);
+    fast_search_batch(tc, queries, 64, rc_res);
+    fast_search_batch(tr, queries, 64, rr_res);
+    ok = 1;
+    for (int i = 0; i < 64; i++) {
+        if (rc_res[i] != rr_res[i]) { ok = 0; break; }
+    }
+    if (ok) PASS(); else FAIL("batch mismatch");
+
+    TEST("compact: duplicates");
+    static const int32_t dup[] = {1, 5, 5, 5, 9, 9, 12};
+    fast_tree_t *td = fast_create_compact(dup, 7);
+    assert(td);
+    ok = fast_search(td, 5) == 3 && fast_search(td, 9) == 5 &&
+         fast_search(td, 4) == 0 && fast_search(td, 0) == -1;
+    if (ok) PASS(); else FAIL("duplicate handling");
+    fast_destroy(td);
+
+    TEST("compact: save/open round trip without rank section");
+    const char *path = "/tmp/fast_test_compact.img";
+    ok = (fast_save(tc, path) == 0);
+    fast_tree_t *m = ok ? fast_open_mmap(path) : NULL;
+    if (m) {
+        for (size_t i = 0; i < N && ok; i += 37) {
+            if (fast_search(m, keys[i]) != (int64_t)i) ok = 0;
+        }
+        fast_destroy(m);
+    } else {
+        ok = 0;
+    }
+    remove(path);
+    if (ok) PASS(); else FAIL("round trip failed");
+
+    fast_destroy(tc);
+    fast_destroy(tr);
+    free(keys);
+}
+
+static void test_numa(void)
+{
+    /* On single-node machines both policies degrade to a plain tree;
+       on multi-socket ones this additionally exercises the replica
+       routing.  Either way results must match fast_create. */
+    static const fast_numa_policy_t policies[] = {
+        FAST_NUMA_INTERLEAVE, FAST_NUMA_REPLICATE
+    };
+    static const char *names[] = {"interleave", "replicate"};
+    const size_t N = 30000;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(keys);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 9 + 5);
+
+    for (size_t p = 0; p < 2; p++) {
+        char name[64];
+        snprintf(name, sizeof(name), "NUMA %s: correct results", names[p]);
+        TEST(name);
+
+        fast_tree_t *t = fast_create_numa(keys, N, policies[p]);
+        assert(t != NULL);
+        int ok = 1;
+        for (size_t i = 0; i < N && ok; i += 5) {
+            if (fast_search(t, keys[i]) != (int64_t)i) ok = 0;
+            if (fast_search(t, keys[i] + 1) != (int64_t)i) ok = 0;
+        }
+        int64_t batch_res[32];
+        int32_t batch_q[32];
+        for (int i = 0; i < 32; i++) batch_q[i] = (int32_t)(i * 911 + 6);
+        fast_search_batch(t, batch_q, 32, batch_res);
+        for (int i = 0; i < 32 && ok; i++) {
+            if (batch_res[i] != fast_search(t, batch_q[i])) ok = 0;
+        }
+        if (ok) PASS(); else FAIL("mismatch");
+        fast_destroy(t);
+    }
+    free(keys);
+}
+
+static void test_compressed(void)
+{
+    TEST("compressed: dense keys (delta-encoded blocks)");
+    const size_t N = 40000;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(keys);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 3 + 7);
+
+    fast_tree_t *tc = fast_create_compressed(keys, N);
+    fast_tree_t *tr = fast_create(keys, N);
+    assert(tc && tr);
+    int ok = 1;
+    for (size_t i = 0; i < N && ok; i++) {
+        if (fast_search(tc, keys[i]) != (int64_t)i) ok = 0;
+        if (fast_search(tc, keys[i] + 1) != (int64_t)i) ok = 0;
+    }
+    if (fast_search(tc, keys[0] - 1) != -1) ok = 0;
+    if (ok) PASS(); else FAIL("mismatch");
+
+    TEST("compressed: batch agreement with uncompressed");
+    int32_t queries[64];
+    int64_t qc[64], qr[64];
+    for (int i = 0; i < 64; i++) queries[i] = (int32_t)(i * 1777 + 2);
+    fast_search_batch(tc, queries, 64, qc);
+    fast_search_batch(tr, queries, 64, qr);
+    ok = 1;
+    for (int i = 0; i < 64; i++) {
+        if (qc[i] != qr[i]) { ok = 0; break; }
+    }
+    if (ok) PASS(); else FAIL("batch mismatch");
+    fast_destroy(tc);
+    fast_destroy(tr);
+
+    TEST("compressed: sparse keys (raw fallback blocks)");
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 100003 - 2000000000);
+    tc = fast_create_compressed(keys, N);
+    assert(tc);
+    ok = 1;
+    for (size_t i = 0; i < N && ok; i++) {
+        if (fast_search(tc, keys[i]) != (int64_t)i) ok = 0;
+        if (fast_search(tc, keys[i] + 1) != (int64_t)i) ok = 0;
+        if (i > 0 && fast_search(tc, keys[i] - 1) != (int64_t)i - 1) ok = 0;
+    }
+    if (ok) PASS(); else FAIL("mismatch");
+    fast_destroy(tc);
+
+    TEST("compressed: mixed-density boundary sizes");
+    static const size_t sizes[] = {1, 2, 2047, 2048, 5000};
+    ok = 1;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && ok; s++) {
+        size_t n = sizes[s];
+        keys[0] = -100000;
+        for (size_t i = 1; i < n; i++)
+            keys[i] = keys[i - 1] + ((i % 97 == 0) ? 70001 : 2);
+        tc = fast_create_compressed(keys, n);
+        assert(tc);
+        for (size_t i = 0; i < n && ok; i++) {
+            if (fast_search(tc, keys[i]) != (int64_t)i) ok = 0;
+        }
+        fast_destroy(tc);
+    }
+    if (ok) PASS(); else FAIL("mismatch");
+
+    free(keys);
+}
+
+struct join_probe {
+    const int32_t *ak, *bk;
+    size_t matches;
+    int ok;
+};
+
+static void join_check(int32_t key, int64_t ia, int64_t ib, void *arg)
+{
+    struct join_probe *p = (struct join_probe *)arg;
+    if (p->ak[ia] != key || p->bk[ib] != key)
+        p->ok = 0;
+    if (ia > 0 && p->ak[ia - 1] == key)
+        p->ok = 0;  /* must report the first occurrence */
+    p->matches++;
+}
+
+static void test_intersect_join(void)
+{
+    TEST("intersect: skewed sizes exercise the galloping skip");
+    const size_t NA = 2000, NB = 300000;
+    int32_t *ak = (int32_t *)malloc(NA * sizeof(int32_t));
+    int32_t *bk = (int32_t *)malloc(NB * sizeof(int32_t));
+    assert(ak && bk);
+    /* a: multiples of 450 (+dups); b: multiples of 3.  Common keys are
+       the multiples of 450 that fall inside b's range. */
+    for (size_t i = 0; i < NA; i++) ak[i] = (int32_t)((i / 2) * 450);
+    for (size_t i = 0; i < NB; i++) bk[i] = (int32_t)(i * 3);
+
+    fast_tree_t *a = fast_create(ak, NA);
+    fast_tree_t *b = fast_create(bk, NB);
+    assert(a && b);
+
+    int32_t *out = (int32_t *)malloc(NA * sizeof(int32_t));
+    assert(out);
+    size_t got = fast_intersect(a, b, out, NA);
+
+    /* Reference: distinct multiples of 450 below both ranges' ends. */
+    size_t want = 0;
+    int ok = 1;
+    for (size_t i = 0; i < NA / 2; i++) {
+        int32_t k = (int32_t)(i * 450);
+        if (k <= bk[NB - 1]) {
+            if (want >= got || out[want] != k) { ok = 0; break; }
+            want++;
+        }
+    }
+    if (ok && got == want) PASS(); else FAIL("wrong intersection");
+
+    TEST("merge join: callback gets first-occurrence indices");
+    struct join_probe p = { ak, bk, 0, 1 };
+    size_t n = fast_merge_join(a, b, join_check, &p);
+    if (p.ok && n == got && p.matches == got) PASS();
+    else FAIL("bad join callbacks");
+
+    TEST("intersect: disjoint and truncated outputs");
+    int32_t small[4];
+    ok = (fast_intersect(a, b, small, 3) == 3 && small[2] == 900);
+    static const int32_t odd[] = {1, 7, 11};
+    fast_tree_t *c = fast_create(odd, 3);
+    assert(c);
+    ok = ok && (fast_intersect(b, c, small, 4) == 0);
+    if (ok) PASS(); else FAIL("edge cases");
+
+    fast_destroy(c);
+    fast_destroy(b);
+    fast_destroy(a);
+    free(out);
+    free(bk);
+    free(ak);
+}
+
+static void test_prefetch_mode(void)
+{
+    /* FAST_PREFETCH only adds cache hints; results must be identical
+       at every width, including across blocking-level boundaries. */
+    TEST("prefetch mode: identical results at every width");
+    const size_t N = 200000;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(keys);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 11 + 3);
+
+    fast_tree_t *base = fast_create(keys, N);
+    assert(base);
+
+    static const char *widths[] = {"sse", "avx2", "avx512"};
+    int ok = 1;
+    setenv("FAST_PREFETCH", "1", 1);
+    for (size_t w = 0; w < 3 && ok; w++) {
+        setenv("FAST_SIMD", widths[w], 1);
+        fast_tree_t *tp = fast_create(keys, N);
+        unsetenv("FAST_SIMD");
+        assert(tp);
+        for (size_t i = 0; i < N && ok; i += 17) {
+            if (fast_search(tp, keys[i]) != fast_search(base, keys[i])) ok = 0;
+            if (fast_search(tp, keys[i] + 4) != fast_search(base, keys[i] + 4)) ok = 0;
+            if (fast_search_lower_bound(tp, keys[i] - 1) !=
+                fast_search_lower_bound(base, keys[i] - 1)) ok = 0;
+        }
+        fast_destroy(tp);
+    }
+    unsetenv("FAST_PREFETCH");
+    if (ok) PASS(); else FAIL("prefetch changed results");
+
+    fast_destroy(base);
+    free(keys);
+}
+
+static void test_gpu_batch(void)
+{
+    TEST("GPU batch: matches CPU batch (or engine unavailable)");
+    const size_t N = 30000;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(keys);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 5 + 2);
+
+    fast_tree_t *t = fast_create(keys, N);
+    assert(t);
+
+    int32_t queries[512];
+    int64_t gpu_res[512], cpu_res[512];
+    for (int i = 0; i < 512; i++) queries[i] = (int32_t)(i * 307 - 100);
+
+    int rc = fast_search_batch_gpu(t, queries, 512, gpu_res);
+    int ok;
+    if (rc == 0) {
+        /* Engine present: results must agree exactly with the CPU tier. */
+        fast_search_batch(t, queries, 512, cpu_res);
+        ok = fast_gpu_available();
+        for (int i = 0; i < 512 && ok; i++) {
+            if (gpu_res[i] != cpu_res[i]) ok = 0;
+        }
+    } else {
+        /* Stub build or no device: -1 tells callers to fall back. */
+        ok = (rc == -1) && !fast_gpu_available();
+    }
+    if (ok) PASS(); else FAIL("GPU/CPU mismatch");
+
+    fast_destroy(t);
+    free(keys);
+}
+
+static void test_insert_merge(void)
+{
+    TEST("insert: merged view matches a from-scratch tree");
+    const size_t N = 20000, M = 700;
+    int32_t *keys = (int32_t *)malloc((N + M) * sizeof(int32_t));
+    int32_t *ins = (int32_t *)malloc(M * sizeof(int32_t));
+    assert(keys && ins);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 6 + 1);
+
+    fast_tree_t *t = fast_create(keys, N);
+    assert(t);
+
+    /* Inserts spanning below, inside (hits and misses) and above the
+       built range; the reference tree is built from the union. */
+    srand(4242);
+    for (size_t i = 0; i < M; i++) {
+        ins[i] = (int32_t)(rand() % (int)(N * 6 + 10000)) - 5000;
+        int irc = fast_insert(t, ins[i]);
+        assert(irc == 0);
+        (void)irc;
+        keys[N + i] = ins[i];
+    }
+    qsort(keys, N + M, sizeof(int32_t), cmp_int32);
+    fast_tree_t *ref = fast_create(keys, N + M);
+    assert(ref);
+
+    int ok = (fast_size(t) == N + M);
+    for (int trial = 0; trial < 2000 && ok; trial++) {
+        int32_t q = (int32_t)(rand() % (int)(N * 6 + 12000)) - 6000;
+        if (fast_search(t, q) != fast_search(ref, q)) ok = 0;
+        if (fast_search_lower_bound(t, q) != fast_search_lower_bound(ref, q)) ok = 0;
+    }
+    for (size_t i = 0; i < N + M && ok; i += 313) {
+        if (fast_key_at(t, i) != keys[i]) ok = 0;
+    }
+    if (ok) PASS(); else FAIL("pre-merge mismatch");
+
+    TEST("insert: batch and range scans see buffered keys");
+    int32_t batch_q[32];
+    int64_t bt[32], br[32];
+    for (int i = 0; i < 32; i++) batch_q[i] = (int32_t)(i * 3701 - 4000);
+    fast_search_batch(t, batch_q, 32, bt);
+    fast_search_batch(ref, batch_q, 32, br);
+    ok = 1;
+    for (int i = 0; i < 32; i++) {
+        if (bt[i] != br[i]) { ok = 0; break; }
+    }
+    int32_t out_t[256], out_r[256];
+    size_t ct = fast_range_copy(t, 500, 9000, out_t, 256);
+    size_t cr = fast_range_copy(ref, 500, 9000, out_r, 256);
+    if (ct != cr || memcmp(out_t, out_r, ct * sizeof(int32_t)) != 0) ok = 0;
+    if (fast_range_count(t, 500, 9000) != fast_range_count(ref, 500, 9000)) ok = 0;
+    if (ok) PASS(); else FAIL("batch/range mismatch");
+
+    TEST("merge: folds the buffer and restores full layout");
+    ok = (fast_save(t, "/tmp/fast_test_pending.img") == -1);  /* pending */
+    ok = ok && (fast_merge(t) == 0);
+    ok = ok && (fast_size(t) == N + M);
+    ok = ok && (memcmp(fast_keys_ptr(t), keys, (N + M) * sizeof(int32_t)) == 0);
+    for (int trial = 0; trial < 2000 && ok; trial++) {
+        int32_t q = (int32_t)(rand() % (int)(N * 6 + 12000)) - 6000;
+        if (fast_search(t, q) != fast_search(ref, q)) ok = 0;
+    }
+    ok = ok && (fast_merge(t) == 0);  /* empty buffer: no-op */
+    if (ok) PASS(); else FAIL("post-merge mismatch");
+    fast_destroy(ref);
+    fast_destroy(t);
+
+    TEST("insert: compressed trees re-transcode on merge");
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 4 + 2);
+    fast_tree_t *tc = fast_create_compressed(keys, N);
+    fast_tree_t *tp = fast_create(keys, N);
+    assert(tc && tp);
+    ok = 1;
+    for (size_t i = 0; i < 200; i++) {
+        int32_t k = (int32_t)(i * 389 + 3);
+        if (fast_insert(tc, k) != 0 || fast_insert(tp, k) != 0) ok = 0;
+    }
+    for (int trial = 0; trial < 500 && ok; trial++) {
+        int32_t q = (int32_t)(rand() % (int)(N * 4 + 1000));
+        if (fast_search(tc, q) != fast_search(tp, q)) ok = 0;
+    }
+    ok = ok && (fast_merge(tc) == 0) && (fast_merge(tp) == 0);
+    for (int trial = 0; trial < 500 && ok; trial++) {
+        int32_t q = (int32_t)(rand() % (int)(N * 4 + 1000));
+        if (fast_search(tc, q) != fast_search(tp, q)) ok = 0;
+    }
+    if (ok) PASS(); else FAIL("compressed merge mismatch");
+    fast_destroy(tp);
+    fast_destroy(tc);
+
+    TEST("insert: rejected on mmap-opened trees");
+    const char *path = "/tmp/fast_test_insert.img";
+    fast_tree_t *ts = fast_create(keys, 1000);
+    assert(ts);
+    ok = (fast_save(ts, path) == 0);
+    fast_tree_t *m = ok ? fast_open_mmap(path) : NULL;
+    if (m) {
+        ok = (fast_insert(m, 42) == -1) && (fast_merge(m) == 0);
+        fast_destroy(m);
+    } else {
+        ok = 0;
+    }
+    remove(path);
+    if (ok) PASS(); else FAIL("mmap tree accepted insert");
+    fast_destroy(ts);
+
+    free(ins);
+    free(keys);
+}
+
+static int cmp_int64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void test_fast64(void)
+{
+    TEST("fast64: keys beyond the 32-bit range");
+    const size_t N = 60000;
+    int64_t *keys = (int64_t *)malloc(N * sizeof(int64_t));
+    assert(keys);
+
+    srand(777);
+    for (size_t i = 0; i < N; i++)
+        keys[i] = (((int64_t)rand() << 31) | rand()) - ((int64_t)1 << 60);
+    qsort(keys, N, sizeof(int64_t), cmp_int64);
+    size_t unique = 1;
+    for (size_t i = 1; i < N; i++) {
+        if (keys[i] != keys[unique - 1])
+            keys[unique++] = keys[i];
+    }
+
+    fast64_tree_t *t = fast64_create(keys, unique);
+    assert(t != NULL);
+    int ok = 1;
+    for (size_t i = 0; i < unique; i++) {
+        if (fast64_search(t, keys[i]) != (int64_t)i) { ok = 0; break; }
+    }
+    if (fast64_search(t, keys[0] - 1) != -1) ok = 0;
+    if (fast64_size(t) != unique || fast64_key_at(t, 5) != keys[5]) ok = 0;
+    if (ok) PASS(); else FAIL("mismatch");
+
+    TEST("fast64: missing keys and lower bound");
+    ok = 1;
+    for (int trial = 0; trial < 1000 && ok; trial++) {
+        int64_t q = (((int64_t)rand() << 31) | rand()) - ((int64_t)1 << 60);
+        int64_t r = fast64_search(t, q);
+        if (q < keys[0]) {
+            if (r != -1) ok = 0;
+        } else {
+            if (r < 0 || r >= (int64_t)unique) ok = 0;
+            else if (keys[r] > q) ok = 0;
+            else if (r + 1 < (int64_t)unique && keys[r + 1] <= q) ok = 0;
+        }
+        int64_t lb = fast64_search_lower_bound(t, q);
+        if (lb < 0 || lb > (int64_t)unique) ok = 0;
+        else if (lb < (int64_t)unique && keys[lb] < q) ok = 0;
+        else if (lb > 0 && keys[lb - 1] >= q) ok = 0;
+    }
+    if (ok) PASS(); else FAIL("incorrect result for missing key");
+
+    /* Each width implies a different blocked layout for 8-byte keys
+       (1, 3 or 7 keys per SIMD block); all must agree. */
+    static const char *widths[] = {"sse", "avx2", "avx512"};
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+        char name[64];
+        snprintf(name, sizeof(name), "fast64 SIMD width %s", widths[w]);
+        TEST(name);
+
+        setenv("FAST_SIMD", widths[w], 1);
+        fast64_tree_t *tw = fast64_create(keys, unique);
+        unsetenv("FAST_SIMD");
+        assert(tw != NULL);
+
+        ok = 1;
+        for (size_t i = 0; i < unique && ok; i += 7) {
+            if (fast64_search(tw, keys[i]) != (int64_t)i) ok = 0;
+            if (fast64_search(tw, keys[i] + 1) != fast64_search(t, keys[i] + 1)) ok = 0;
+        }
+        if (ok) PASS(); else FAIL("mismatch");
+        fast64_destroy(tw);
+    }
+
+    fast64_destroy(t);
+    free(keys);
+}
+
 static void test_large_random(void)
 {
     const size_t N = 100000;
@@ -246,6 +1044,636 @@ static void test_large_random(void)
     free(keys);
 }
 
+struct kv_payload {
+    int64_t a;
+    int32_t b;
+};
+
+static void test_kv(void)
+{
+    TEST("kv: payload returned with the search index");
+    const size_t N = 10000;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    struct kv_payload *vals =
+        (struct kv_payload *)malloc(N * sizeof(struct kv_payload));
+    assert(keys && vals);
+    for (size_t i = 0; i < N; i++) {
+        keys[i] = (int32_t)(i * 4 + 1);
+        vals[i].a = (int64_t)keys[i] * 10;
+        vals[i].b = (int32_t)i;
+    }
+
+    fast_tree_t *t = fast_create_kv(keys, vals, N, sizeof(struct kv_payload));
+    assert(t);
+    int ok = 1;
+    for (size_t i = 0; i < N && ok; i += 17) {
+        struct kv_payload out;
+        int64_t idx = fast_search_value(t, keys[i] + 2, &out);   /* miss up */
+        if (idx != fast_search(t, keys[i] + 2)) ok = 0;
+        if (out.a != (int64_t)keys[idx] * 10 || out.b != (int32_t)idx) ok = 0;
+    }
+    if (ok) PASS(); else FAIL("kv payload mismatch");
+
+    TEST("kv: miss below all keys leaves the payload untouched");
+    struct kv_payload out = { -7, -7 };
+    ok = (fast_search_value(t, -100, &out) == -1) && out.a == -7 && out.b == -7;
+    ok = ok && (fast_insert(t, 5) == -1);       /* kv trees are build-once */
+    ok = ok && (fast_save(t, "/tmp/fast_test_kv.img") == -1);
+    const struct kv_payload *vp =
+        (const struct kv_payload *)fast_values_ptr(t);
+    ok = ok && vp && vp[3].b == 3;
+    if (ok) PASS(); else FAIL("kv miss/guard handling");
+
+    fast_destroy(t);
+    free(vals);
+    free(keys);
+}
+
+static void test_tiered(void)
+{
+    TEST("tiered: identical results under a skewed sample");
+    const size_t N = 60000;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(keys);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 3 + 7);
+
+    /* 90% of the sample hammers one narrow key range. */
+    int32_t sample[2000];
+    srand(777);
+    for (int i = 0; i < 2000; i++) {
+        sample[i] = (i % 10 == 0)
+            ? (int32_t)(rand() % (int)(N * 3))
+            : (int32_t)(1000 + rand() % 500);
+    }
+
+    fast_tree_t *th = fast_create_tiered(keys, N, sample, 2000);
+    fast_tree_t *tr = fast_create(keys, N);
+    assert(th && tr);
+    int ok = 1;
+    for (size_t i = 0; i < N && ok; i += 23) {
+        if (fast_search(th, keys[i]) != fast_search(tr, keys[i])) ok = 0;
+        if (fast_search(th, keys[i] + 1) != fast_search(tr, keys[i] + 1)) ok = 0;
+        if (fast_search_lower_bound(th, keys[i]) !=
+            fast_search_lower_bound(tr, keys[i])) ok = 0;
+    }
+    if (ok) PASS(); else FAIL("tiered/plain mismatch");
+
+    TEST("tiered: empty sample degrades to plain create");
+    fast_tree_t *tn = fast_create_tiered(keys, N, NULL, 0);
+    ok = (tn != NULL);
+    for (size_t i = 0; ok && i < N; i += 101) {
+        if (fast_search(tn, keys[i]) != (int64_t)i) ok = 0;
+    }
+    if (ok) PASS(); else FAIL("unsampled tiered tree broken");
+
+    fast_destroy(tn);
+    fast_destroy(tr);
+    fast_destroy(th);
+    free(keys);
+}
+
+static void test_stats(void)
+{
+    TEST("stats: fresh tree reports zero or compiled out");
+    const size_t N = 4096;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(keys);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 2);
+
+    fast_tree_t *t = fast_create(keys, N);
+    assert(t);
+    struct fast_stats st;
+    int avail = fast_stats_get(t, &st);
+    int ok = (avail == 0)
+        ? (st.searches == 0 && st.levels == 0 && st.batch_rounds == 0)
+        : (avail == -1);
+    if (ok) PASS(); else FAIL("unexpected initial counters");
+
+    /* 200 interior descents, 2 boundary exits, one pipelined batch. */
+    for (size_t i = 1; i <= 200; i++)
+        (void)fast_search(t, keys[i] + 1);
+    (void)fast_search(t, keys[0] - 10);
+    (void)fast_search(t, keys[N - 1] + 10);
+    int32_t q[64];
+    int64_t r[64];
+    for (int i = 0; i < 64; i++) q[i] = keys[(size_t)i * 37] + 1;
+    fast_search_batch(t, q, 64, r);
+
+    TEST("stats: counters advance under load");
+    if (fast_stats_get(t, &st) == 0) {
+        ok = st.searches >= 200 &&
+             st.levels >= st.searches &&      /* d_N levels per descent */
+             st.bounds_exits >= 2 &&
+             st.batch_rounds >= 1 &&
+             st.batch_steps >= st.batch_rounds;
+    } else {
+        ok = (avail == -1);   /* compiled out: stays unavailable */
+    }
+    if (ok) PASS(); else FAIL("counters did not advance");
+
+    TEST("stats: invalid arguments rejected");
+    ok = (fast_stats_get(NULL, &st) == -1) && (fast_stats_get(t, NULL) == -1);
+    if (ok) PASS(); else FAIL("expected -1");
+
+    fast_destroy(t);
+    free(keys);
+}
+
+struct str_ref {
+    uint8_t b[20];
+    size_t len;
+};
+
+static int str_ref_cmp(const void *a, const void *b)
+{
+    const struct str_ref *x = (const struct str_ref *)a;
+    const struct str_ref *y = (const struct str_ref *)b;
+    size_t m = x->len < y->len ? x->len : y->len;
+    int c = memcmp(x->b, y->b, m);
+    if (c) return c;
+    return (x->len > y->len) - (x->len < y->len);
+}
+
+static void test_str(void)
+{
+    TEST("str: URL keys sharing a long prefix");
+    const char *urls[] = {
+        "https://a.example/",
+        "https://a.example/x",
+        "https://b.example/1",
+        "https://b.example/2",
+        "https://c.example/index.html",
+    };
+    const void *keys[5];
+    size_t lens[5];
+    for (int i = 0; i < 5; i++) {
+        keys[i] = urls[i];
+        lens[i] = strlen(urls[i]);
+    }
+    fast_str_tree_t *t = fast_str_create(keys, lens, 5);
+    assert(t);
+    assert(fast_str_size(t) == 5);
+    int ok = 1;
+    for (int i = 0; i < 5; i++)
+        if (fast_str_search(t, urls[i], lens[i]) != i) ok = 0;
+    if (fast_str_search(t, "https://b.example/15", 20) != 2) ok = 0;
+    if (fast_str_search(t, "http:", 5) != -1) ok = 0;
+    if (fast_str_search(t, "zzz", 3) != 4) ok = 0;
+    if (fast_str_lower_bound(t, "https://b.example/2", 19) != 3) ok = 0;
+    if (fast_str_lower_bound(t, "zzz", 3) != 5) ok = 0;
+    if (ok) PASS(); else FAIL("URL lookups wrong");
+    fast_str_destroy(t);
+
+    TEST("str: short keys and tail tie-breaking");
+    const char *shorts[] = {
+        "", "ab", "abc", "abcd", "abcdefgh", "abcdefghi", "abcdefghij"
+    };
+    const void *skeys[7];
+    size_t slens[7];
+    for (int i = 0; i < 7; i++) {
+        skeys[i] = shorts[i];
+        slens[i] = strlen(shorts[i]);
+    }
+    t = fast_str_create(skeys, slens, 7);
+    assert(t);
+    ok = 1;
+    for (int i = 0; i < 7; i++)
+        if (fast_str_search(t, shorts[i], slens[i]) != i) ok = 0;
+    /* differs from its neighbors only past the 8-byte prefix */
+    if (fast_str_search(t, "abcdefghh", 9) != 4) ok = 0;
+    if (fast_str_lower_bound(t, "abcdefghh", 9) != 5) ok = 0;
+    if (fast_str_search(t, "abcz", 4) != 6) ok = 0;
+    if (fast_str_search(t, "a", 1) != 0) ok = 0;
+    if (ok) PASS(); else FAIL("short-key lookups wrong");
+
+    TEST("str: key_at round trip");
+    ok = 1;
+    for (int i = 0; i < 7; i++) {
+        char buf[32];
+        size_t len = fast_str_key_at(t, (size_t)i, buf, sizeof(buf));
+        if (len != slens[i] || memcmp(buf, shorts[i], len) != 0) ok = 0;
+    }
+    if (fast_str_key_at(t, 7, NULL, 0) != 0) ok = 0;
+    if (ok) PASS(); else FAIL("key_at mismatch");
+    fast_str_destroy(t);
+
+    TEST("str: random keys agree with a scalar reference");
+    enum { SN = 400, SQ = 400 };
+    struct str_ref *ref = (struct str_ref *)malloc(SN * sizeof(*ref));
+    const void **rkeys = (const void **)malloc(SN * sizeof(void *));
+    size_t *rlens = (size_t *)malloc(SN * sizeof(size_t));
+    assert(ref && rkeys && rlens);
+    srand(4242);
+    for (int i = 0; i < SN; i++) {
+        /* tiny alphabet + short lengths force shared prefixes */
+        ref[i].len = (size_t)(rand() % 17);
+        for (size_t j = 0; j < ref[i].len; j++)
+            ref[i].b[j] = (uint8_t)('a' + rand() % 3);
+    }
+    qsort(ref, SN, sizeof(*ref), str_ref_cmp);
+    for (int i = 0; i < SN; i++) {
+        rkeys[i] = ref[i].b;
+        rlens[i] = ref[i].len;
+    }
+    t = fast_str_create(rkeys, rlens, SN);
+    assert(t);
+    ok = 1;
+    for (int i = 0; i < SQ && ok; i++) {
+        struct str_ref q;
+        q.len = (size_t)(rand() % 17);
+        for (size_t j = 0; j < q.len; j++)
+            q.b[j] = (uint8_t)('a' + rand() % 3);
+
+        int64_t want = -1;
+        for (int k = 0; k < SN; k++) {
+            if (str_ref_cmp(&ref[k], &q) <= 0)
+                want = k;
+            else
+                break;
+        }
+        if (fast_str_search(t, q.b, q.len) != want) ok = 0;
+        int64_t want_lb = (want >= 0 && str_ref_cmp(&ref[want], &q) == 0)
+            ? want : want + 1;
+        /* duplicates: the reference picks the last equal key, the
+           lower bound wants the first */
+        while (want_lb > 0 && str_ref_cmp(&ref[want_lb - 1], &q) == 0)
+            want_lb--;
+        if (fast_str_lower_bound(t, q.b, q.len) != want_lb) ok = 0;
+    }
+    if (ok) PASS(); else FAIL("reference mismatch");
+    fast_str_destroy(t);
+    free(ref);
+    free(rkeys);
+    free(rlens);
+}
+
+/*
+ * Handle stress: readers loop acquire/search/release while the main
+ * thread publishes a stream of replacement trees.  Every published
+ * tree has keys[i] = 2i + generation, so any probe against a
+ * half-destroyed tree shows up as a wrong or wild index.
+ */
+#define HANDLE_READERS 4
+#define HANDLE_KEYS    2048
+
+struct handle_reader_arg {
+    fast_handle_t *h;
+    volatile int *stop;
+    int bad;
+};
+
+static void *handle_reader(void *argp)
+{
+    struct handle_reader_arg *arg = (struct handle_reader_arg *)argp;
+
+    while (!*arg->stop) {
+        const fast_tree_t *t = fast_handle_acquire(arg->h);
+        if (!t)
+            continue;
+        /* generation is keys[0]; every key must then be 2i + gen */
+        int32_t gen = fast_key_at(t, 0);
+        for (int i = 0; i < 50; i++) {
+            int64_t idx = fast_search(t, 2 * (i * 31) + gen);
+            if (idx != i * 31)
+                arg->bad = 1;
+        }
+        fast_handle_release(arg->h, t);
+    }
+    return NULL;
+}
+
+static void test_handle(void)
+{
+    int32_t keys[HANDLE_KEYS];
+
+    TEST("handle: acquire sees the published tree");
+    for (int i = 0; i < HANDLE_KEYS; i++) keys[i] = 2 * i;
+    fast_handle_t *h = fast_handle_create(NULL);
+    assert(h);
+    int ok = (fast_handle_acquire(h) == NULL);
+    int prc = fast_handle_publish(h, fast_create(keys, HANDLE_KEYS));
+    assert(prc == 0);
+    (void)prc;
+    const fast_tree_t *t = fast_handle_acquire(h);
+    ok = ok && t && fast_search(t, 100) == 50;
+    fast_handle_release(h, t);
+    if (ok) PASS(); else FAIL("snapshot wrong");
+
+    TEST("handle: publish replaces and reclaims");
+    for (int i = 0; i < HANDLE_KEYS; i++) keys[i] = 2 * i + 1;
+    prc = fast_handle_publish(h, fast_create(keys, HANDLE_KEYS));
+    assert(prc == 0);
+    (void)prc;
+    t = fast_handle_acquire(h);
+    ok = t && fast_key_at(t, 0) == 1 && fast_search(t, 101) == 50;
+    fast_handle_release(h, t);
+    if (ok) PASS(); else FAIL("stale tree after publish");
+
+    TEST("handle: readers race a stream of publishes");
+    volatile int stop = 0;
+    struct handle_reader_arg args[HANDLE_READERS];
+    pthread_t tids[HANDLE_READERS];
+    for (int r = 0; r < HANDLE_READERS; r++) {
+        args[r].h = h;
+        args[r].stop = &stop;
+        args[r].bad = 0;
+        int rc = pthread_create(&tids[r], NULL, handle_reader, &args[r]);
+        assert(rc == 0);
+        (void)rc;
+    }
+    ok = 1;
+    for (int gen = 0; gen < 200; gen++) {
+        for (int i = 0; i < HANDLE_KEYS; i++)
+            keys[i] = 2 * i + (gen & 1);
+        fast_tree_t *nt = fast_create(keys, HANDLE_KEYS);
+        assert(nt);
+        if (fast_handle_publish(h, nt) != 0) ok = 0;
+    }
+    stop = 1;
+    for (int r = 0; r < HANDLE_READERS; r++) {
+        pthread_join(tids[r], NULL);
+        if (args[r].bad) ok = 0;
+    }
+    if (ok) PASS(); else FAIL("reader raced a reclaim");
+
+    fast_handle_destroy(h);
+}
+
+static void test_cursor(void)
+{
+    const size_t N = 4096;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(keys);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 3 + 1);
+
+    TEST("cursor: event loop agrees with the direct searches");
+    fast_tree_t *t = fast_create(keys, N);
+    assert(t);
+    enum { CURSORS = 32 };
+    fast_cursor_t curs[CURSORS];
+    int32_t q[CURSORS];
+    int ok = 1;
+    for (int round = 0; ok && round < 8; round++) {
+        /* Mix of hits, misses, and both boundary sides, half of them
+           driven as lower-bound cursors. */
+        for (int c = 0; c < CURSORS; c++) {
+            size_t i = (size_t)(round * CURSORS + c) * 17 % N;
+            q[c] = keys[i] + (c % 3) - 1;
+            if (c == 0) q[c] = keys[0] - 5;
+            if (c == 1) q[c] = keys[N - 1] + 5;
+            if (c & 1)
+                fast_lower_bound_begin(t, q[c], &curs[c]);
+            else
+                fast_search_begin(t, q[c], &curs[c]);
+        }
+        /* Round-robin, the way a request multiplexer would drive it. */
+        int pending = CURSORS;
+        while (pending > 0) {
+            pending = 0;
+            for (int c = 0; c < CURSORS; c++)
+                if (!fast_search_step(&curs[c])) pending++;
+        }
+        for (int c = 0; c < CURSORS; c++) {
+            int64_t want = (c & 1) ? fast_search_lower_bound(t, q[c])
+                                   : fast_search(t, q[c]);
+            if (curs[c].result != want) ok = 0;
+        }
+    }
+    if (ok) PASS(); else FAIL("interleaved result diverged");
+    fast_destroy(t);
+
+    TEST("cursor: unmerged inserts shift the suspended result");
+    t = fast_create(keys, N);
+    assert(t);
+    for (int i = 0; i < 40; i++) {
+        int irc = fast_insert(t, (int32_t)(i * 300));
+        assert(irc == 0);
+        (void)irc;
+    }
+    ok = 1;
+    for (size_t i = 0; ok && i < N; i += 97) {
+        fast_cursor_t cur;
+        fast_search_begin(t, keys[i] + 1, &cur);
+        while (!fast_search_step(&cur))
+            ;
+        if (cur.result != fast_search(t, keys[i] + 1)) ok = 0;
+        fast_lower_bound_begin(t, keys[i], &cur);
+        while (!fast_search_step(&cur))
+            ;
+        if (cur.result != fast_search_lower_bound(t, keys[i])) ok = 0;
+    }
+    if (ok) PASS(); else FAIL("delta adjustment wrong");
+    fast_destroy(t);
+
+    TEST("cursor: non-resumable modes complete in begin");
+    fast_tree_t *tc = fast_create_compressed(keys, N);
+    assert(tc);
+    ok = 1;
+    for (size_t i = 0; ok && i < N; i += 211) {
+        fast_cursor_t cur;
+        fast_search_begin(tc, keys[i], &cur);
+        if (!cur.done || fast_search_step(&cur) != 1) ok = 0;
+        if (cur.result != fast_search(tc, keys[i])) ok = 0;
+    }
+    fast_cursor_t cur;
+    fast_search_begin(NULL, 7, &cur);
+    ok = ok && cur.done && cur.result == -1;
+    fast_lower_bound_begin(NULL, 7, &cur);
+    ok = ok && cur.done && cur.result == 0;
+    if (ok) PASS(); else FAIL("synchronous fallback wrong");
+    fast_destroy(tc);
+
+    free(keys);
+}
+
+static void test_create_unsorted(void)
+{
+    TEST("unsorted: random input agrees with sort-then-create");
+    const size_t N = 60000;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    int32_t *sorted = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(keys && sorted);
+    uint64_t seed = 0x5eedf00d;
+    for (size_t i = 0; i < N; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        /* Full signed range, duplicates included. */
+        keys[i] = (int32_t)(seed >> 32);
+    }
+    memcpy(sorted, keys, N * sizeof(int32_t));
+    qsort(sorted, N, sizeof(int32_t), cmp_int32);
+
+    fast_tree_t *t = fast_create_unsorted(keys, N);
+    fast_tree_t *ref = fast_create(sorted, N);
+    assert(t && ref);
+    int ok = (fast_size(t) == N);
+    for (size_t i = 0; ok && i < N; i += 37) {
+        if (fast_key_at(t, i) != sorted[i]) ok = 0;
+        if (fast_search(t, sorted[i]) != fast_search(ref, sorted[i])) ok = 0;
+        if (fast_search_lower_bound(t, sorted[i] + 1) !=
+            fast_search_lower_bound(ref, sorted[i] + 1)) ok = 0;
+    }
+    if (ok) PASS(); else FAIL("radix order diverged");
+    fast_destroy(t);
+    fast_destroy(ref);
+
+    TEST("unsorted: sorted and reverse-sorted input");
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 3) - 1000;
+    t = fast_create_unsorted(keys, N);       /* pre-scan short-circuit */
+    ok = t && fast_key_at(t, 0) == -1000 && fast_search(t, keys[N - 1]) ==
+        (int64_t)(N - 1);
+    fast_destroy(t);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)((N - 1 - i) * 3) - 1000;
+    t = fast_create_unsorted(keys, N);
+    ok = ok && t && fast_key_at(t, 0) == -1000 &&
+        fast_key_at(t, N - 1) == (int32_t)((N - 1) * 3) - 1000;
+    fast_destroy(t);
+    if (ok) PASS(); else FAIL("ordered input mishandled");
+
+    TEST("unsorted: narrow key range (pass skipping)");
+    for (size_t i = 0; i < N; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        keys[i] = (int32_t)((seed >> 32) & 0xff);   /* only low byte varies */
+    }
+    memcpy(sorted, keys, N * sizeof(int32_t));
+    qsort(sorted, N, sizeof(int32_t), cmp_int32);
+    t = fast_create_unsorted(keys, N);
+    ok = (t != NULL);
+    for (size_t i = 0; ok && i < N; i += 101)
+        if (fast_key_at(t, i) != sorted[i]) ok = 0;
+    if (ok) PASS(); else FAIL("skipped pass corrupted order");
+    fast_destroy(t);
+
+    free(sorted);
+    free(keys);
+}
+
+static void test_forest(void)
+{
+    TEST("forest: routed searches agree with one big tree");
+    enum { FOREST_SHARDS = 8 };
+    const size_t N = 8000;             /* 1000 keys per shard */
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(keys);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 7) - 5000;
+
+    fast_tree_t *ref = fast_create(keys, N);
+    fast_tree_t *shards[FOREST_SHARDS];
+    int32_t bounds[FOREST_SHARDS];
+    size_t per = N / FOREST_SHARDS;
+    for (int s = 0; s < FOREST_SHARDS; s++) {
+        shards[s] = fast_create(keys + (size_t)s * per, per);
+        assert(shards[s]);
+        bounds[s] = keys[(size_t)s * per];
+    }
+    fast_forest_t *f = fast_forest_create(shards, bounds, FOREST_SHARDS);
+    assert(ref && f);
+    int ok = (fast_forest_size(f) == N);
+    for (size_t i = 0; ok && i < N; i += 23) {
+        /* Hits, misses, and the keys straddling shard boundaries. */
+        for (int d = -1; d <= 1; d++) {
+            int32_t q = keys[i] + d;
+            if (fast_forest_search(f, q) != fast_search(ref, q)) ok = 0;
+            if (fast_forest_lower_bound(f, q) !=
+                fast_search_lower_bound(ref, q)) ok = 0;
+        }
+    }
+    ok = ok && fast_forest_search(f, keys[0] - 1) == -1 &&
+        fast_forest_search(f, keys[N - 1] + 1) == (int64_t)(N - 1) &&
+        fast_forest_lower_bound(f, keys[N - 1] + 1) == (int64_t)N;
+    if (ok) PASS(); else FAIL("forest result diverged");
+
+    TEST("forest: batch groups per shard and matches");
+    const size_t M = 3000;
+    int32_t *q = (int32_t *)malloc(M * sizeof(int32_t));
+    int64_t *r = (int64_t *)malloc(M * sizeof(int64_t));
+    assert(q && r);
+    uint64_t seed = 0xf04e57;
+    for (size_t i = 0; i < M; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        /* Shard-hopping mix spanning both sides of the key range. */
+        q[i] = (int32_t)((seed >> 33) % (N * 7 + 2000)) - 6000;
+    }
+    fast_forest_search_batch(f, q, M, r);
+    ok = 1;
+    for (size_t i = 0; ok && i < M; i++)
+        if (r[i] != fast_search(ref, q[i])) ok = 0;
+    if (ok) PASS(); else FAIL("batch result diverged");
+    free(r);
+    free(q);
+
+    TEST("forest: invalid arguments rejected");
+    int32_t bad_bounds[2] = { 10, 10 };   /* not strictly increasing */
+    fast_tree_t *two[2] = { ref, ref };
+    ok = (fast_forest_create(NULL, bounds, FOREST_SHARDS) == NULL) &&
+         (fast_forest_create(shards, NULL, FOREST_SHARDS) == NULL) &&
+         (fast_forest_create(shards, bounds, 0) == NULL) &&
+         (fast_forest_create(two, bad_bounds, 2) == NULL) &&
+         (fast_forest_search(NULL, 1) == -1);
+    if (ok) PASS(); else FAIL("bad create accepted");
+
+    fast_forest_destroy(f);       /* destroys the shards */
+    fast_destroy(ref);
+    free(keys);
+}
+
+static void test_arena(void)
+{
+    TEST("arena: trees agree with heap-built trees");
+    const size_t N = 5000;
+    int32_t *keys = (int32_t *)malloc(N * sizeof(int32_t));
+    assert(keys);
+    for (size_t i = 0; i < N; i++) keys[i] = (int32_t)(i * 5 + 2);
+
+    fast_arena_t *arena = fast_arena_create(4u << 20);
+    assert(arena);
+
+    fast_tree_t *ref = fast_create(keys, N);
+    fast_tree_t *ta[4];
+    int ok = 1;
+    for (int k = 0; k < 4; k++) {
+        ta[k] = fast_create_in(arena, keys, N - (size_t)k * 700);
+        if (!ta[k]) { ok = 0; break; }
+    }
+    for (size_t i = 0; ok && i < N; i += 13) {
+        if (fast_search(ta[0], keys[i]) != fast_search(ref, keys[i])) ok = 0;
+        if (fast_search(ta[0], keys[i] + 1) != fast_search(ref, keys[i] + 1)) ok = 0;
+        if (fast_search_lower_bound(ta[0], keys[i]) !=
+            fast_search_lower_bound(ref, keys[i])) ok = 0;
+    }
+    for (size_t i = 0; ok && i < N - 2100; i += 17) {
+        if (fast_search(ta[3], keys[i]) != (int64_t)i) ok = 0;
+    }
+    if (ok) PASS(); else FAIL("arena/heap mismatch");
+
+    TEST("arena: build-once and no-op destroy");
+    ok = (fast_insert(ta[1], 12345) == -1) && (fast_merge(ta[1]) == 0);
+    fast_destroy(ta[1]);   /* must not free arena memory */
+    ok = ok && fast_search(ta[2], keys[40]) == 40;
+    if (ok) PASS(); else FAIL("arena tree mutated or freed");
+
+    TEST("arena: reset reclaims full capacity");
+    fast_arena_reset(arena);
+    ok = 1;
+    for (int k = 0; ok && k < 4; k++) {
+        fast_tree_t *t = fast_create_in(arena, keys, N);
+        if (!t || fast_search(t, keys[99]) != 99) ok = 0;
+        fast_arena_reset(arena);
+    }
+    if (ok) PASS(); else FAIL("rebuild after reset failed");
+
+    TEST("arena: exhaustion returns NULL");
+    fast_arena_t *tiny = fast_arena_create(4096);
+    assert(tiny);
+    ok = (fast_create_in(tiny, keys, N) == NULL) &&
+         (fast_create_in(NULL, keys, N) == NULL);
+    fast_arena_destroy(tiny);
+    if (ok) PASS(); else FAIL("undersized arena did not fail cleanly");
+
+    fast_arena_destroy(arena);
+    fast_destroy(ref);
+    free(keys);
+}
+
 int main(void)
 {
     printf("FAST Tree Tests\n");
@@ -257,6 +1685,30 @@ int main(void)
     test_non_power_of_two();
     test_duplicates();
     test_lower_bound();
+    test_range_scan();
+    test_page_block_boundary();
+    test_batch_search();
+    test_simd_widths();
+    test_huge_pages();
+    test_parallel_build();
+    test_save_open();
+    test_compact();
+    test_compressed();
+    test_numa();
+    test_insert_merge();
+    test_prefetch_mode();
+    test_intersect_join();
+    test_gpu_batch();
+    test_kv();
+    test_tiered();
+    test_stats();
+    test_str();
+    test_handle();
+    test_cursor();
+    test_create_unsorted();
+    test_forest();
+    test_arena();
+    test_fast64();
     test_large_random();
 
     printf("\n%d / %d tests passed\n", tests_passed, tests_run);